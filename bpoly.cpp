@@ -0,0 +1,187 @@
+// vim: et:sw=4:ts=4
+// read and write binary polygon (.bpoly) files.
+// the layout is described in the README; all numbers are little endian,
+// and every array starts at a multiple of 8 bytes, so that the file can
+// be used in place once it is mapped into memory.
+
+#include "util.h"
+#include <fstream>
+#include <stdexcept>
+#include <string.h>
+#include <limits.h>
+typedef std::string string;
+
+static const char BPOLY_MAGIC[8] = { 'P', 'A', 'P', 'A', 'Y', 'A', 'B', 'P' };
+static const unsigned BPOLY_VERSION = 1;
+static const unsigned BPOLY_FLOAT = 1, BPOLY_LABELS = 2;
+static const long BPOLY_HEADER_SIZE = 32;
+
+static void format_error (const string &filename, const string &msg) {
+    throw std::runtime_error ("\"" + filename + "\": " + msg);
+}
+
+static long padded (long bytes) {
+    return (bytes + 7) & ~7L;
+}
+
+// little endian encoding, independent of the host.  the 64 bit
+// numbers are written as two 32 bit halves.
+static void put_u32 (std::ostream &os, unsigned long v) {
+    char buf[4];
+    for (int i = 0; i != 4; ++i, v >>= 8)
+        buf[i] = char (v & 0xff);
+    os.write (buf, 4);
+}
+
+static void put_u64 (std::ostream &os, unsigned long v) {
+    put_u32 (os, v & 0xffffffffUL);
+    put_u32 (os, (v >> 16) >> 16);
+}
+
+static unsigned long get_u32 (const char *p) {
+    unsigned long v = 0;
+    for (int i = 4; i--; )
+        v = v << 8 | (unsigned char)p[i];
+    return v;
+}
+
+static unsigned long get_u64 (const char *p) {
+    return get_u32 (p) | (get_u32 (p + 4) << 16) << 16;
+}
+
+static bool little_endian_host () {
+    const unsigned one = 1;
+    return *(const unsigned char *)&one == 1;
+}
+
+// floating point numbers are copied bytewise, swapping them on big
+// endian hosts
+template <typename T>
+static void put_real (std::ostream &os, T x) {
+    char buf[sizeof (T)];
+    memcpy (buf, &x, sizeof (T));
+    if (!little_endian_host ())
+        std::reverse (buf, buf + sizeof (T));
+    os.write (buf, sizeof (T));
+}
+
+template <typename T>
+static T get_real (const char *p) {
+    char buf[sizeof (T)];
+    memcpy (buf, p, sizeof (T));
+    if (!little_endian_host ())
+        std::reverse (buf, buf + sizeof (T));
+    T x;
+    memcpy (&x, buf, sizeof (T));
+    return x;
+}
+
+static void pad (std::ostream &os, long bytes) {
+    for (; bytes != padded (bytes); ++bytes)
+        os.put ('\0');
+}
+
+void save_bpoly (const string &filename, const Boundary &b,
+                 bool with_labels, bool single_precision) {
+    FrozenBoundary f (b);
+    std::ofstream os (filename.c_str (), std::ios::out | std::ios::binary);
+    if (!os)
+        throw std::runtime_error ("Cannot open \"" + filename + "\"");
+    os.exceptions (std::ios::failbit | std::ios::badbit);
+    const long n = f.num_edges ();
+    os.write (BPOLY_MAGIC, 8);
+    put_u32 (os, BPOLY_VERSION);
+    put_u32 (os, (single_precision ? BPOLY_FLOAT : 0) |
+                 (with_labels ? BPOLY_LABELS : 0));
+    put_u64 (os, f.num_contours ());
+    put_u64 (os, n);
+    for (int c = 0; c <= f.num_contours (); ++c)
+        put_u64 (os, c == f.num_contours () ? n : f.contour_begin (c));
+    const double *coords[2] = { f.x (), f.y () };
+    for (int k = 0; k != 2; ++k) {
+        for (long i = 0; i != n; ++i)
+            if (single_precision)
+                put_real (os, float (coords[k][i]));
+            else
+                put_real (os, coords[k][i]);
+        pad (os, n * (single_precision ? 4 : 8));
+    }
+    if (with_labels) {
+        for (long i = 0; i != n; ++i)
+            put_u32 (os, (unsigned)f.labels ()[i]);
+        pad (os, n * 4);
+    }
+}
+
+void load_bpoly (Boundary *b, const string &filename) {
+    MappedFile file (filename);
+    const char *p = file.data ();
+    if (file.size () < BPOLY_HEADER_SIZE || memcmp (p, BPOLY_MAGIC, 8))
+        format_error (filename, "not a binary polygon file");
+    const unsigned long version = get_u32 (p + 8);
+    if (version != BPOLY_VERSION)
+        format_error (filename, "unsupported binary polygon file version");
+    const unsigned long flags = get_u32 (p + 12);
+    const unsigned long num_contours = get_u64 (p + 16);
+    const unsigned long n = get_u64 (p + 24);
+    const int coord_size = flags & BPOLY_FLOAT ? 4 : 8;
+    if (num_contours > (unsigned long)INT_MAX || n > (unsigned long)INT_MAX)
+        format_error (filename, "too many vertices");
+    const long offsets_at = BPOLY_HEADER_SIZE;
+    const long x_at = offsets_at + 8 * long (num_contours + 1);
+    const long y_at = x_at + padded (coord_size * long (n));
+    const long labels_at = y_at + padded (coord_size * long (n));
+    const long end = labels_at + (flags & BPOLY_LABELS ? padded (4 * long (n)) : 0);
+    if (file.size () < end)
+        format_error (filename, "file is truncated");
+
+    const int first_contour = b->num_contours ();
+    int begin = 0;
+    for (int c = 0; c != int (num_contours); ++c) {
+        const unsigned long contour_end = get_u64 (p + offsets_at + 8 * (c+1));
+        if (get_u64 (p + offsets_at + 8 * c) != (unsigned long)begin ||
+                contour_end > n || contour_end < (unsigned long)begin + 2)
+            format_error (filename, "invalid contour offsets");
+        int initial_vertex = Boundary::INVALID_VERTEX, prev_vertex = 0;
+        int initial_edge = Boundary::INVALID_EDGE, prev_edge = 0;
+        for (int i = begin; i != int (contour_end); ++i) {
+            double x, y;
+            if (coord_size == 4) {
+                x = get_real <float> (p + x_at + 4 * long (i));
+                y = get_real <float> (p + y_at + 4 * long (i));
+            } else {
+                x = get_real <double> (p + x_at + 8 * long (i));
+                y = get_real <double> (p + y_at + 8 * long (i));
+            }
+            int vertex = b->insert_vertex (x, y);
+            if (initial_vertex == Boundary::INVALID_VERTEX) {
+                initial_vertex = vertex;
+            } else if (initial_edge == Boundary::INVALID_EDGE) {
+                initial_edge = prev_edge = b->insert_edge (
+                    Boundary::INVALID_EDGE, prev_vertex, vertex,
+                    Boundary::INVALID_EDGE);
+            } else {
+                prev_edge = b->insert_edge (prev_edge, prev_vertex, vertex,
+                                            Boundary::INVALID_EDGE);
+            }
+            prev_vertex = vertex;
+        }
+        // close contour
+        b->insert_edge (prev_edge, prev_vertex, initial_vertex, initial_edge);
+        begin = int (contour_end);
+    }
+    if ((unsigned long)begin != n ||
+            get_u64 (p + offsets_at + 8 * num_contours) != n)
+        format_error (filename, "invalid contour offsets");
+
+    if (flags & BPOLY_LABELS) {
+        // the contours are traversed in the order they were inserted,
+        // starting from their first edge
+        int i = 0;
+        Boundary::contour_iterator cit;
+        Boundary::edge_iterator eit;
+        for (cit = b->contours_begin () + first_contour; cit != b->contours_end (); ++cit)
+        for (eit = b->edges_begin (cit); eit != b->edges_end (cit); ++eit, ++i)
+            b->edge_label (eit, (int)get_u32 (p + labels_at + 4 * long (i)));
+    }
+}
@@ -5,15 +5,20 @@
 #include <getopt_pp_standalone.h>
 #include <sys/stat.h>
 #include <sys/types.h>
+#include <unistd.h>
 #include <string>
 #include <errno.h>
+#include <pthread.h>
+#include <glob.h>
+#include <sstream>
+#include <set>
+#include <algorithm>
 #include "util.h"
 #include "minkval.h"
+#include "libpapaya_internal.h"
 #include "tinyconf.h"
 using namespace GetOpt;
 
-typedef AbstractMinkowskiFunctional **func_iterator;
-
 static bool ends_with (const std::string &s1, const std::string &s2) {
     if (s1.size () < s2.size ())
         return false;
@@ -25,11 +30,13 @@ std::string detect_fileformat (std::string filename)
 {
     if (ends_with (filename, ".poly")) {
         return "poly";
+    } else if (ends_with (filename, ".bpoly")) {
+        return "bpoly";
     } else if (ends_with (filename, ".pgm") || ends_with (filename, ".pbm")) {
         return "pgm";
     } else {
         die ("Cannot deduce the input file format from filename %s.  "
-            "Please specify --format=poly or --format=pgm.",
+            "Please specify --format=poly, --format=bpoly or --format=pgm.",
             filename.c_str ());
     }
 }
@@ -47,6 +54,32 @@ std::string my_basename (const std::string &str) {
         return std::string (str, j+1, str.npos);
 }
 
+static
+int num_online_cpus () {
+    long n = sysconf (_SC_NPROCESSORS_ONLN);
+    return n > 0 ? int (n) : 1;
+}
+
+// hands the contours found by streaming_marching_squares to the
+// functionals
+class FunctionalSink : public FrozenBoundarySink {
+public:
+    explicit FunctionalSink (FusedMinkowskiFunctionals *f)
+        : my_f (f) {
+    }
+
+    void add_boundary (const FrozenBoundary &b) {
+        my_f->add_boundary (b);
+    }
+
+    void merge_labels (const std::vector <int> &new_label, int num_labels) {
+        my_f->merge_labels (new_label, num_labels);
+    }
+
+private:
+    FusedMinkowskiFunctionals *my_f;
+};
+
 typedef std::vector <std::string> string_vector;
 
 static
@@ -81,6 +114,7 @@ string_vector parse_what_to_compute (std::string what)
     const int num_tensors = sizeof(tensors)/sizeof(*tensors);
     string_vector legal_options (tensors, tensors+num_tensors);
     legal_options.push_back ("contours");
+    legal_options.push_back ("boundary");
     legal_options.push_back ("labels");
     legal_options.push_back ("scalars");
     legal_options.push_back ("vectors");
@@ -117,93 +151,7 @@ void prefix_mkdir (std::string prefix)
         perror ("mkdir");
 }
 
-static void calculate_functional (AbstractMinkowskiFunctional *p,
-                                  const Boundary &b) {
-    Boundary::contour_iterator cit;
-    for (cit = b.contours_begin (); cit != b.contours_end (); ++cit)
-        p->add_contour (b, b.edges_begin (cit), b.edges_end (cit));
-}
-
-static void set_refvert_com (func_iterator begin, func_iterator end,
-                             const Boundary &b, int num_labels) {
-    VectorMinkowskiFunctional *w010 = create_w010 ();
-    ScalarMinkowskiFunctional *w000 = create_w000 ();
-    w010->global_ref_vertex (vec_t (0., 0.));
-    calculate_functional (w010, b);
-    calculate_functional (w000, b);
-    for (; begin != end; ++begin) {
-        for (int l = 0; l != num_labels; ++l) {
-            vec_t refvert = w010->value (l) / w000->value (l);
-            (*begin)->ref_vertex (l, refvert);
-        }
-    }
-    delete w010;
-    delete w000;
-}
-
-static void set_refvert_cos (func_iterator begin, func_iterator end,
-                             const Boundary &b, int num_labels) {
-    VectorMinkowskiFunctional *w110 = create_w110 ();
-    ScalarMinkowskiFunctional *w100 = create_w100 ();
-    w110->global_ref_vertex (vec_t (0., 0.));
-    calculate_functional (w110, b);
-    calculate_functional (w100, b);
-    for (; begin != end; ++begin) {
-        for (int l = 0; l != num_labels; ++l) {
-            vec_t refvert = w110->value (l) / w100->value (l);
-            (*begin)->ref_vertex (l, refvert);
-        }
-    }
-    delete w110;
-    delete w100;
-}
-
-static void set_refvert_coc (func_iterator begin, func_iterator end,
-                             const Boundary &b, int num_labels) {
-    VectorMinkowskiFunctional *w210 = create_w210 ();
-    ScalarMinkowskiFunctional *w200 = create_w200 ();
-    w210->global_ref_vertex (vec_t (0., 0.));
-    calculate_functional (w210, b);
-    calculate_functional (w200, b);
-    for (; begin != end; ++begin) {
-        for (int l = 0; l != num_labels; ++l) {
-            if (fabs (w200->value (l) / W2_NORMALIZATION) < .95*M_PI)
-            {
-                std::cerr << "error: some labels have vanishing total curvature.\n"
-                             "the _coc reference vertex does not exist in this case.\n"
-                             "you probably want to use point_of_reference = contour_com or component_com instead.\n";
-                exit (1);
-            }
-            vec_t refvert = w210->value (l) / w200->value (l);
-            (*begin)->ref_vertex (l, refvert);
-        }
-    }
-    delete w210;
-    delete w200;
-}
-
-static void set_refvert_origin (func_iterator begin, func_iterator end,
-                                int num_labels) {
-    vec_t refvert = vec_t (0., 0.);
-    for (; begin != end; ++begin) {
-        for (int l = 0; l != num_labels; ++l) {
-            (*begin)->ref_vertex (l, refvert);
-        }
-    }
-}
-
-static void set_refvert_domain_center (func_iterator begin, func_iterator end,
-                                       const rect_t &r,
-                                       int xdomains, int ydomains) {
-    for (; begin != end; ++begin) {
-        for (int l = 0; l != xdomains*ydomains; ++l) {
-            (*begin)->ref_vertex (l, label_domain_center (
-                l, r, xdomains, ydomains));
-        }
-    }
-}
-
-static void save_ref_vertex_map (AbstractMinkowskiFunctional  *w020,
+static void save_ref_vertex_map (AbstractMinkowskiFunctional  *func,
                                  std::string output_prefix,
                                  int precision,
                                  int xdomains, int ydomains) {
@@ -229,212 +177,169 @@ static void save_ref_vertex_map (AbstractMinkowskiFunctional  *w020,
         of << " " << std::setw (19) << l;
         of << " " << std::setw (19) << (l%xdomains);
         of << " " << std::setw (19) << (l/xdomains);
-        of << " " << std::setw (19) << std::setprecision (precision) << (w020->ref_vertex (l)[0]);
-        of << " " << std::setw (19) << std::setprecision (precision) << (w020->ref_vertex (l)[1]);
+        of << " " << std::setw (19) << std::setprecision (precision) << (func->ref_vertex (l)[0]);
+        of << " " << std::setw (19) << std::setprecision (precision) << (func->ref_vertex (l)[1]);
         of << "\n";
     }
 }
 
+// a quantity for each window, one row of windows per line.  the top row
+// (largest y) comes first, so the windows are in the same places as in
+// the input image.  quantity is empty for scalars; for tensors, it is the
+// anisotropy eval2/eval1, or the angle of the first eigenvector (the one
+// with the larger eigenvalue) against the x axis, in [0, pi).
+static double window_map_value (const ScalarMinkowskiFunctional &f, int l,
+                                const std::string &) {
+    return f.value (l);
+}
 
-// the gigantic main function of the program.
-int main (int argc, char **argv) {
-    GetOpt_pp ops (argc, argv);
-
-    if (ops >> OptionPresent ('v', "version")) {
-        std::cerr << "papaya " << VERSION << "\n";
-        return 0;
-    }
+static double window_map_value (const MatrixMinkowskiFunctional &f, int l,
+                                const std::string &quantity) {
+    EigenSystem esys;
+    eigensystem_symm (&esys, f.value (l));
+    if (fabs (esys.eval[0]) < fabs (esys.eval[1]))
+        swap_eigenvalues (&esys);
+    if (quantity == "anisotropy")
+        return esys.eval[1]/esys.eval[0];
+    double angle = atan2 (esys.evec[0][1], esys.evec[0][0]);
+    if (angle < 0.)
+        angle += M_PI;
+    if (angle >= M_PI)
+        angle -= M_PI;
+    return angle;
+}
 
-    // preparing the config file, and the command line.
-    std::string configfile = my_basename (argv[0]) + ".conf";
-    if (ops >> OptionPresent ('c', "config")) {
-        ops >> Option ('c', "config", configfile);
+template <typename FUNCTIONAL>
+static void save_window_map (const std::string &filename, int precision,
+                             const FUNCTIONAL &f, const std::string &quantity,
+                             int cols, int rows) {
+    std::ofstream of (filename.c_str ());
+    if (!of)
+        std::cerr << "[papaya] WARNING unable to open " << filename << "\n";
+    print_version_header (of);
+    of << "# " << f.name () << (quantity.empty () ? "" : " ") << quantity
+       << ", " << cols << " x " << rows << " windows\n";
+    for (int y = rows - 1; y >= 0; --y) {
+        for (int x = 0; x != cols; ++x)
+            of << (x ? " " : "") << std::setprecision (precision)
+               << window_map_value (f, y*cols + x, quantity);
+        of << "\n";
     }
-    std::cerr << "[papaya] Using config file " << configfile << "\n";
-    Configuration conf (configfile);
+}
 
-    std::string filename = conf.string ("input", "filename");
-    std::string in_fileformat = conf.string ("input", "format", "deduce_from_filename");
-    if (ops >> OptionPresent ('i', "input"))
-        // override the input specified in config file
-        ops >> Option ('i', "input", filename);
-    if (ops >> OptionPresent ('F', "format"))
-        ops >> Option ('F', "format", in_fileformat);
-    if (in_fileformat == "deduce_from_filename")
-        in_fileformat = detect_fileformat (filename);
 
-    std::cerr << "[papaya] Using input file " << filename << "\n";
+static void save_level_sets (const std::string &filename, int precision,
+                             const Pixmap &image,
+                             const std::vector <double> &thresholds,
+                             bool connectblack, bool periodic_data) {
+    std::vector <level_set_t> level_sets;
+    level_set_sweep (&level_sets, image, thresholds, connectblack,
+                     periodic_data);
+    std::ofstream of (filename.c_str ());
+    if (!of)
+        std::cerr << "[papaya] WARNING unable to open " << filename << "\n";
+    print_version_header (of);
 
-    std::string output_prefix = conf.string ("output", "prefix");
-    if (ops >> OptionPresent ('o', "output")) {
-        // override the output specified in config file
-        ops >> Option ('o', "output", output_prefix);
-    }
-    std::cerr << "[papaya] Using output prefix " << output_prefix << "\n";
-    if (conf.boolean ("output", "mkdir", false))
-        prefix_mkdir (output_prefix);
+    of << std::setw (20) << "#   1      threshold";
+    int col = 2;
+    of << std::setw ( 4) << col++;
+    of << std::setw (16) << "w000";
+    of << std::setw ( 4) << col++;
+    of << std::setw (16) << "w100";
+    of << std::setw ( 4) << col++;
+    of << std::setw (16) << "w200";
+    of << std::setw ( 4) << col++;
+    of << std::setw (16) << "euler";
+    of << "\n";
 
-    double thresh_override = -INFINITY;
-    if (ops >> OptionPresent ('\0', "threshold")) {
-        ops >> Option ('\0', "threshold", thresh_override);
-        std::cerr << "[papaya] Using threshold " << thresh_override << "\n";
+    for (int i = 0; i != (int)level_sets.size (); ++i) {
+        const level_set_t &l = level_sets[i];
+        of << " " << std::setw (19) << std::setprecision (precision) << l.threshold;
+        of << " " << std::setw (19) << std::setprecision (precision) << l.area * W0_NORMALIZATION;
+        of << " " << std::setw (19) << std::setprecision (precision) << l.perimeter * W1_NORMALIZATION;
+        of << " " << std::setw (19) << std::setprecision (precision) << 2*M_PI * l.euler * W2_NORMALIZATION;
+        of << " " << std::setw (19) << l.euler;
+        of << "\n";
     }
+}
 
-    int precision = conf.integer ("output", "precision");
-
-    std::string normalization = conf.string ("output", "normalization", "code_default");
-    if (ops >> OptionPresent ('N', "normalization"))
-        ops >> Option ('N', "normalization", normalization);
-    if (normalization == "breidenbach") {
-        W0_NORMALIZATION = W1_NORMALIZATION = W2_NORMALIZATION = 1.;
-    } else if (normalization == "new") {
-        W0_NORMALIZATION = 1.;
-        W1_NORMALIZATION = W2_NORMALIZATION = .5;
-    } else if (normalization == "code_default") {
-    } else {
-        std::cerr << "Invalid normalization setting: " << normalization << std::endl;
-        return 1;
-    }
+// everything evaluate () needs to know, apart from the configuration
+struct settings_t {
+    std::string filename;
+    std::string output_prefix;
+    string_vector what_to_compute;
+    int precision;
+    int num_threads;
+    bool fused, streaming;
+    double threshold;
+    bool invert_image, connectblack, periodic_data;
+    bool interpolate;
+};
 
-    Boundary b, b_for_w0_storage_;
-    Boundary *b_for_w0 = &b;
+// the totals over all the labels of one input, for the summary of a
+// batch run
+struct summary_t {
+    int num_labels;
+    double threshold, w000, w100, w200;
+};
 
-    if (in_fileformat == "poly") {
-        load_poly (&b, filename);
-        if (thresh_override != -INFINITY) {
-            std::cerr << "--threshold is not useful in .poly mode.\n";
-            abort ();
+// the functionals we're going to write out; the others are left NULL.
+// they are deleted along with it, also when die () throws in batch mode.
+class OwnedFunctionals : public FusedMinkowskiFunctionals {
+public:
+    explicit OwnedFunctionals (const string_vector &what_to_compute) {
+        if (vector_contains (what_to_compute, "scalars")) {
+            w000 = create_w000 ();
+            w100 = create_w100 ();
+            w200 = create_w200 ();
         }
-        bool runfix   = conf.boolean ("polyinput", "fix_contours");
-        bool forceccw = conf.boolean ("polyinput", "force_counterclockwise");
-        if (runfix)
-            fix_contours (&b, conf.boolean ("polyinput", "silent_fix_contours"));
-        if (forceccw)
-            force_counterclockwise_contours (&b);
-    } else if (in_fileformat == "pgm" || in_fileformat == "pbm") {
-        Pixmap p;
-        load_pgm (&p, filename);
-        if (conf.boolean ("segment", "invert"))
-            invert (&p);
-        double threshold  = conf.floating ("segment", "threshold");
-        if (thresh_override != -INFINITY)
-            threshold = thresh_override;
-        bool connectblack = conf.boolean ("segment", "connectblack");
-        bool periodic_data = conf.boolean ("segment", "data_is_periodic");
-        marching_squares (&b, p, threshold, connectblack, periodic_data);
-    } else {
-        std::cerr << "only .pgm, .pbm and .poly files are valid input"
-                  << "(\"" <<  filename << "\")" << std::endl;
-        abort ();
-    }
-
-    assert_sensible_boundary (b);
-
-    // find out what we're supposed to compute
-    std::string default_what = "contours,labels,scalars,vectors,tensors";
-    string_vector what_to_compute =
-        parse_what_to_compute (conf.string ("output", "compute", default_what));
-    if (ops >> OptionPresent (' ', "compute")) {
-        std::string what;
-        ops >> Option (' ', "compute", what);
-        what_to_compute = parse_what_to_compute (what);
+        if (vector_contains (what_to_compute, "vectors")) {
+            w010 = create_w010 ();
+            w110 = create_w110 ();
+            w210 = create_w210 ();
+        }
+        if (vector_contains (what_to_compute, "W020"))
+            w020 = create_w020 ();
+        if (vector_contains (what_to_compute, "W120"))
+            w120 = create_w120 ();
+        if (vector_contains (what_to_compute, "W102"))
+            w102 = create_w102 ();
+        if (vector_contains (what_to_compute, "W220"))
+            w220 = create_w220 ();
+        if (vector_contains (what_to_compute, "W211"))
+            w211 = create_w211 ();
     }
-
-    // write contours prior to labelling (in case that crashes...)
-    if (vector_contains (what_to_compute, "contours")) {
-        std::string contfile (output_prefix + "contours");
-        dump_contours (contfile, b, 1);
+    ~OwnedFunctionals () {
+        delete w000;
+        delete w100;
+        delete w200;
+        delete w010;
+        delete w110;
+        delete w210;
+        delete w020;
+        delete w120;
+        delete w220;
+        delete w211;
+        delete w102;
     }
 
-    ScalarMinkowskiFunctional *w000 = create_w000 ();
-    ScalarMinkowskiFunctional *w100 = create_w100 ();
-    ScalarMinkowskiFunctional *w200 = create_w200 ();
-    VectorMinkowskiFunctional *w010 = create_w010 ();
-    VectorMinkowskiFunctional *w110 = create_w110 ();
-    VectorMinkowskiFunctional *w210 = create_w210 ();
-    MatrixMinkowskiFunctional *w020 = create_w020 ();
-    MatrixMinkowskiFunctional *w120 = create_w120 ();
-    MatrixMinkowskiFunctional *w102 = create_w102 ();
-    MatrixMinkowskiFunctional *w220 = create_w220 ();
-    MatrixMinkowskiFunctional *w211 = create_w211 ();
+private:
+    OwnedFunctionals (const OwnedFunctionals &);
+    OwnedFunctionals &operator= (const OwnedFunctionals &);
+};
 
-    AbstractMinkowskiFunctional *all_funcs[]
-        = { w000, w100, w200, w020, w120, w102, w220, w211, w010, w110, w210 };
-    func_iterator all_funcs_begin = all_funcs;
-    func_iterator all_funcs_end   = all_funcs
-                                    + sizeof (all_funcs)/sizeof (*all_funcs);
-
-    std::string labcrit = conf.string ("output", "labels");
-    std::string point_of_ref = conf.string ("output", "point_of_reference");
-    int num_labels = -1;
-    if (labcrit == "none") {
-        num_labels = label_none (&b);
-        set_refvert_origin (all_funcs_begin, all_funcs_end, num_labels);
-    } else if (labcrit == "by_contour") {
-        num_labels = label_by_contour_index (&b);
-        if (point_of_ref == "contour_com")
-            set_refvert_com (all_funcs_begin, all_funcs_end, b, num_labels);
-        else if (point_of_ref == "contour_cos")
-            set_refvert_cos (all_funcs_begin, all_funcs_end, b, num_labels);
-        else if (point_of_ref == "contour_coc")
-            set_refvert_coc (all_funcs_begin, all_funcs_end, b, num_labels);
-        else if (point_of_ref == "origin")
-            set_refvert_origin (all_funcs_begin, all_funcs_end, num_labels);
-        else
-            die ("option \"point_of_reference\" in section [output] has illegal value");
-    } else if (labcrit == "by_component") {
-        num_labels = label_by_component (&b);
-        if (point_of_ref == "component_com")
-            set_refvert_com (all_funcs_begin, all_funcs_end, b, num_labels);
-        else if (point_of_ref == "component_cos")
-            set_refvert_cos (all_funcs_begin, all_funcs_end, b, num_labels);
-        else if (point_of_ref == "component_coc")
-            set_refvert_coc (all_funcs_begin, all_funcs_end, b, num_labels);
-        else if (point_of_ref == "origin")
-            set_refvert_origin (all_funcs_begin, all_funcs_end, num_labels);
-        else
-            die ("option \"point_of_reference\" in section [output] has illegal value");
-    } else if (labcrit == "by_domain") {
-        rect_t r;
-        r.top    = conf.floating ("domains", "clip_top");
-        r.right  = conf.floating ("domains", "clip_right");
-        r.bottom = conf.floating ("domains", "clip_bottom");
-        r.left   = conf.floating ("domains", "clip_left");
-        int xdomains = conf.integer ("domains", "xdomains");
-        int ydomains = conf.integer ("domains", "ydomains");
-        b_for_w0_storage_ = b;
-        b_for_w0 = &b_for_w0_storage_;
-        num_labels = label_by_domain (&b, r, xdomains, ydomains, false);
-                     label_by_domain (b_for_w0, r, xdomains, ydomains, true);
-        if (point_of_ref == "origin")
-            set_refvert_origin (all_funcs_begin, all_funcs_end, num_labels);
-        else if (point_of_ref == "domain_center")
-            set_refvert_domain_center (all_funcs_begin, all_funcs_end, r, xdomains, ydomains);
-        else 
-            die ("option \"point_of_reference\" in section [output] has illegal value");
-
-        save_ref_vertex_map (w020, output_prefix, precision, xdomains, ydomains);
-    } else {
-        die ("option \"labels\" in section [output] has illegal value");
-    }
-
-    assert (num_labels != -1);
-    if (vector_contains (what_to_compute, "labels")) {
-        dump_labels (output_prefix + "labels", b);
-        dump_labels (output_prefix + "nu0labels", *b_for_w0);
-    }
-
-    {
-        // calculate all functionals
-        func_iterator it;
-
-        for (it = all_funcs_begin; it != all_funcs_end; ++it) {
-            if (*it == w000 || *it == w010 || *it == w020)
-                calculate_functional (*it, *b_for_w0);
-            else
-                calculate_functional (*it, b);
-        }
-    }
+// write out the values of the functionals for labels [0, num_labels)
+static void save_functionals (const FusedMinkowskiFunctionals &funcs,
+                              const std::string &output_prefix,
+                              const string_vector &what_to_compute,
+                              int precision, int num_labels) {
+    ScalarMinkowskiFunctional *w000 = funcs.w000, *w100 = funcs.w100,
+                              *w200 = funcs.w200;
+    VectorMinkowskiFunctional *w010 = funcs.w010, *w110 = funcs.w110,
+                              *w210 = funcs.w210;
+    MatrixMinkowskiFunctional *w020 = funcs.w020, *w120 = funcs.w120,
+                              *w102 = funcs.w102, *w220 = funcs.w220,
+                              *w211 = funcs.w211;
 
     if (vector_contains (what_to_compute, "scalars"))
     {
@@ -512,7 +417,7 @@ int main (int argc, char **argv) {
         MatrixMinkowskiFunctional **it;
         for (it = all_mat_begin; it != all_mat_end; ++it) {
             MatrixMinkowskiFunctional *p = *it;
-            if (!vector_contains (what_to_compute, p->name ()))
+            if (!p)
                 continue;
             std::string filename = output_prefix + "tensor_" + p->name () + ".out";
             std::ofstream of (filename.c_str ());
@@ -568,18 +473,887 @@ int main (int argc, char **argv) {
             }
         }
     }
+}
+
+// the coarser levels of a quadtree over the domains of b, which is
+// labelled by domain already.  the sums over the domains are taken once,
+// about the center of the clipping rectangle, and added up level by
+// level; for the output, they are moved to the reference points of each
+// level.  level n x m goes to <prefix>level_<n>x<m>/.
+static void save_domain_pyramid (const settings_t &settings,
+                                 const std::string &point_of_ref,
+                                 const Boundary &b, const Boundary &b_w0,
+                                 const rect_t &r, int xdomains, int ydomains) {
+    vec_t center (.5 * (r.left + r.right), .5 * (r.top + r.bottom));
+    std::vector <minkowski_sums_t> sums, coarser;
+    minkowski_sums (&sums, b, b_w0, xdomains * ydomains, center,
+                    settings.num_threads);
+    while (xdomains % 2 == 0 && ydomains % 2 == 0) {
+        coarser_domains (&coarser, sums, xdomains, ydomains);
+        sums.swap (coarser);
+        xdomains /= 2;
+        ydomains /= 2;
+        std::ostringstream prefix;
+        prefix << settings.output_prefix << "level_"
+               << xdomains << "x" << ydomains << "/";
+        prefix_mkdir (prefix.str ());
+        std::cerr << "[papaya] " << xdomains << " x " << ydomains
+                  << " domains, output prefix " << prefix.str () << "\n";
+
+        OwnedFunctionals funcs (settings.what_to_compute);
+        AbstractMinkowskiFunctional *all_funcs[] = { funcs.w020, funcs.w120,
+            funcs.w220, funcs.w010, funcs.w110, funcs.w210 };
+        func_iterator all_funcs_end = std::remove (all_funcs, all_funcs + 6,
+            (AbstractMinkowskiFunctional *)0);
+        const int num_labels = xdomains * ydomains;
+        for (int l = 0; l != num_labels; ++l) {
+            vec_t refvert (0., 0.);
+            if (point_of_ref == "domain_center")
+                refvert = label_domain_center (l, r, xdomains, ydomains);
+            for (func_iterator it = all_funcs; it != all_funcs_end; ++it)
+                (*it)->ref_vertex (l, refvert);
+            minkowski_sums_t s = sums[l];
+            refvert -= center;
+            s.translate (refvert);
+            funcs.add_sums (l, s);
+        }
+        if (all_funcs != all_funcs_end)
+            save_ref_vertex_map (*all_funcs, prefix.str (),
+                                 settings.precision, xdomains, ydomains);
+        save_functionals (funcs, prefix.str (), settings.what_to_compute,
+                          settings.precision, num_labels);
+    }
+}
+
+// segment the image (unless this is done in fused mode, or the input is
+// a .poly file), label the contours, evaluate the functionals and write
+// out everything for one threshold.
+static void evaluate (const Configuration &conf, const settings_t &settings,
+                      Boundary &b, const Pixmap *image,
+                      summary_t *summary = 0) {
+    const std::string &filename = settings.filename;
+    const std::string &output_prefix = settings.output_prefix;
+    const string_vector &what_to_compute = settings.what_to_compute;
+    const int precision = settings.precision;
+    const int num_threads = settings.num_threads;
+    const bool fused = settings.fused;
+    const bool streaming = settings.streaming;
+    const double threshold = settings.threshold;
+    const bool invert_image = settings.invert_image;
+    const bool connectblack = settings.connectblack;
+    const bool periodic_data = settings.periodic_data;
+    const bool interpolate = settings.interpolate;
+
+    if (image && !fused)
+        marching_squares (&b, *image, threshold, connectblack, periodic_data,
+                          num_threads, interpolate);
+    assert_sensible_boundary (b);
+    // the geometry of b is final now, except for the by_domain
+    // labelling which splits edges and thereby drops the cache.
+    b.cache_geometry ();
+
+    Boundary b_for_w0_storage_;
+    Boundary *b_for_w0 = &b;
+
+    // write contours prior to labelling (in case that crashes...)
+    if (vector_contains (what_to_compute, "contours")) {
+        std::string contfile (output_prefix + "contours");
+        dump_contours (contfile, b, 1);
+    }
+    // the same in binary, to be read back with --format=bpoly
+    if (vector_contains (what_to_compute, "boundary"))
+        save_bpoly (output_prefix + "boundary.bpoly", b);
+
+    // only create the functionals we're going to write out;
+    // the others are left NULL.
+    OwnedFunctionals funcs (what_to_compute);
+    ScalarMinkowskiFunctional *w000 = funcs.w000, *w100 = funcs.w100,
+                              *w200 = funcs.w200;
+    VectorMinkowskiFunctional *w010 = funcs.w010, *w110 = funcs.w110,
+                              *w210 = funcs.w210;
+    MatrixMinkowskiFunctional *w020 = funcs.w020, *w120 = funcs.w120,
+                              *w102 = funcs.w102, *w220 = funcs.w220,
+                              *w211 = funcs.w211;
+    bool need_w0_boundary = w000 || w010 || w020;
+
+    // the functionals which depend on the point of reference.
+    // the reference points are only calculated if this list is non-empty.
+    AbstractMinkowskiFunctional *all_funcs[]
+        = { w020, w120, w220, w010, w110, w210 };
+    func_iterator all_funcs_begin = all_funcs;
+    func_iterator all_funcs_end   = all_funcs
+                                    + sizeof (all_funcs)/sizeof (*all_funcs);
+    all_funcs_end = std::remove (all_funcs_begin, all_funcs_end,
+                                 (AbstractMinkowskiFunctional *)0);
+
+    // in by_domain mode with sliding windows, the sums over each window,
+    // which go into the functionals instead of the edges
+    std::vector <minkowski_sums_t> windows;
+    int window_cols = 0, window_rows = 0;
 
-    delete w000;
-    delete w100;
-    delete w200;
-    delete w010;
-    delete w110;
-    delete w210;
-    delete w020;
-    delete w120;
-    delete w220;
-    delete w211;
-    delete w102;
+    std::string labcrit = conf.string ("output", "labels");
+    std::string point_of_ref = conf.string ("output", "point_of_reference");
+    int num_labels = -1;
+    if (fused && labcrit != "none" &&
+        !(labcrit == "by_component" && point_of_ref == "origin"))
+        die ("Fused and streaming mode require labels = none, or by_component "
+             "with point_of_reference = origin.");
+    if (labcrit == "none") {
+        num_labels = label_none (&b);
+        set_refvert_origin (all_funcs_begin, all_funcs_end, num_labels);
+    } else if (labcrit == "by_contour") {
+        num_labels = label_by_contour_index (&b);
+        if (point_of_ref == "contour_com")
+            set_refvert_com (all_funcs_begin, all_funcs_end, b, num_labels);
+        else if (point_of_ref == "contour_cos")
+            set_refvert_cos (all_funcs_begin, all_funcs_end, b, num_labels);
+        else if (point_of_ref == "contour_coc")
+            set_refvert_coc (all_funcs_begin, all_funcs_end, b, num_labels);
+        else if (point_of_ref == "origin")
+            set_refvert_origin (all_funcs_begin, all_funcs_end, num_labels);
+        else
+            die ("option \"point_of_reference\" in section [output] has illegal value");
+    } else if (labcrit == "by_component") {
+        num_labels = label_by_component (&b);
+        if (point_of_ref == "component_com")
+            set_refvert_com (all_funcs_begin, all_funcs_end, b, num_labels);
+        else if (point_of_ref == "component_cos")
+            set_refvert_cos (all_funcs_begin, all_funcs_end, b, num_labels);
+        else if (point_of_ref == "component_coc")
+            set_refvert_coc (all_funcs_begin, all_funcs_end, b, num_labels);
+        else if (point_of_ref == "origin")
+            set_refvert_origin (all_funcs_begin, all_funcs_end, num_labels);
+        else
+            die ("option \"point_of_reference\" in section [output] has illegal value");
+    } else if (labcrit == "by_domain") {
+        rect_t r;
+        r.top    = conf.floating ("domains", "clip_top");
+        r.right  = conf.floating ("domains", "clip_right");
+        r.bottom = conf.floating ("domains", "clip_bottom");
+        r.left   = conf.floating ("domains", "clip_left");
+        int xdomains = conf.integer ("domains", "xdomains");
+        int ydomains = conf.integer ("domains", "ydomains");
+        // sliding windows made of xwindow x ywindow domains
+        int xwindow = conf.integer ("domains", "xwindow", 0);
+        int ywindow = conf.integer ("domains", "ywindow", 0);
+        const bool sliding = xwindow || ywindow;
+        // all the coarser levels of a quadtree over the domains
+        const bool pyramid = conf.boolean ("domains", "pyramid", false);
+        if (pyramid && (sliding || xdomains % 2 || ydomains % 2))
+            die ("The domain pyramid needs an even number of domains in "
+                 "both directions, and no sliding windows.");
+        if (need_w0_boundary) {
+            b_for_w0_storage_ = b;
+            b_for_w0 = &b_for_w0_storage_;
+            label_by_domain (b_for_w0, r, xdomains, ydomains, true);
+        } else {
+            // no separate labelling for the W0 functionals.
+            b_for_w0 = 0;
+        }
+        num_labels = label_by_domain (&b, r, xdomains, ydomains, false);
+        if (point_of_ref != "origin" && point_of_ref != "domain_center")
+            die ("option \"point_of_reference\" in section [output] has illegal value");
+        if (sliding) {
+            // the domains are only the cells the windows are made of.
+            // the sums over the cells are taken once, about the center of
+            // the clipping rectangle, and the windows are put together
+            // from them; the labels are the windows from here on.
+            if (xwindow <= 0)
+                xwindow = 1;
+            if (ywindow <= 0)
+                ywindow = 1;
+            int xstride = conf.integer ("domains", "xstride", 1);
+            int ystride = conf.integer ("domains", "ystride", 1);
+            if (xwindow > xdomains || ywindow > ydomains ||
+                xstride <= 0 || ystride <= 0)
+                die ("Invalid window size or stride in section [domains].");
+            vec_t center (.5 * (r.left + r.right), .5 * (r.top + r.bottom));
+            std::vector <minkowski_sums_t> cells;
+            minkowski_sums (&cells, b, b_for_w0 ? *b_for_w0 : b, num_labels,
+                            center, num_threads);
+            window_sums (&windows, cells, xdomains, ydomains,
+                         xwindow, ywindow, xstride, ystride);
+            window_cols = (xdomains - xwindow) / xstride + 1;
+            window_rows = (ydomains - ywindow) / ystride + 1;
+            num_labels = window_cols * window_rows;
+            for (int l = 0; l != num_labels; ++l) {
+                vec_t refvert (0., 0.);
+                if (point_of_ref == "domain_center") {
+                    // halfway between the centers of the corner cells
+                    int x0 = (l % window_cols) * xstride;
+                    int y0 = (l / window_cols) * ystride;
+                    refvert  = label_domain_center (
+                        y0 * xdomains + x0, r, xdomains, ydomains);
+                    refvert += label_domain_center (
+                        (y0+ywindow-1) * xdomains + x0+xwindow-1, r,
+                        xdomains, ydomains);
+                    refvert *= .5;
+                }
+                vec_t d = refvert;
+                d -= center;
+                windows[l].translate (d);
+                for (func_iterator it = all_funcs_begin; it != all_funcs_end; ++it)
+                    (*it)->ref_vertex (l, refvert);
+            }
+            xdomains = window_cols;
+            ydomains = window_rows;
+        } else if (point_of_ref == "origin") {
+            set_refvert_origin (all_funcs_begin, all_funcs_end, num_labels);
+        } else {
+            set_refvert_domain_center (all_funcs_begin, all_funcs_end, r, xdomains, ydomains);
+        }
+
+        if (all_funcs_begin != all_funcs_end)
+            save_ref_vertex_map (*all_funcs_begin, output_prefix, precision,
+                                 xdomains, ydomains);
+        if (pyramid)
+            save_domain_pyramid (settings, point_of_ref, b,
+                                 b_for_w0 ? *b_for_w0 : b, r,
+                                 xdomains, ydomains);
+    } else {
+        die ("option \"labels\" in section [output] has illegal value");
+    }
+
+    assert (num_labels != -1);
+    if (vector_contains (what_to_compute, "labels")) {
+        dump_labels (output_prefix + "labels", b);
+        if (b_for_w0)
+            dump_labels (output_prefix + "nu0labels", *b_for_w0);
+    }
+
+    {
+        // calculate all functionals, in a single sweep over a compacted
+        // copy of each boundary.
+        // W000, W010 and W020 are taken from b_for_w0, which is a separate
+        // boundary in by_domain mode.
+        FusedMinkowskiFunctionals f, f_w0_storage_;
+        FusedMinkowskiFunctionals *f_w0 = &f;
+        if (b_for_w0 && b_for_w0 != &b)
+            f_w0 = &f_w0_storage_;
+        f_w0->w000 = w000;
+        f_w0->w010 = w010;
+        f_w0->w020 = w020;
+        f.w100 = w100;
+        f.w200 = w200;
+        f.w110 = w110;
+        f.w210 = w210;
+        f.w120 = w120;
+        f.w102 = w102;
+        f.w220 = w220;
+        f.w211 = w211;
+        f.num_threads = num_threads;
+        f_w0->num_threads = num_threads;
+        if (fused) {
+            // labels are found while tracing; all reference points are
+            // at the origin.
+            FunctionalSink sink (&f);
+            const bool by_component = labcrit == "by_component";
+            if (streaming) {
+                PgmRowReader reader (filename);
+                reader.invert = invert_image;
+                num_labels = streaming_marching_squares (
+                    &sink, &reader, threshold, connectblack, periodic_data,
+                    by_component, interpolate);
+            } else {
+                PixmapRowReader reader (*image);
+                num_labels = streaming_marching_squares (
+                    &sink, &reader, threshold, connectblack, periodic_data,
+                    by_component, interpolate);
+            }
+        } else if (!windows.empty ()) {
+            for (int l = 0; l != num_labels; ++l) {
+                f.add_sums (l, windows[l]);
+                if (f_w0 != &f)
+                    f_w0->add_sums (l, windows[l]);
+            }
+        } else {
+            f.add_boundary (FrozenBoundary (b));
+        }
+        if (f_w0 != &f && windows.empty ())
+            f_w0->add_boundary (FrozenBoundary (*b_for_w0));
+    }
+
+    if (summary) {
+        summary->num_labels = num_labels;
+        summary->threshold = threshold;
+        summary->w000 = summary->w100 = summary->w200 =
+            std::numeric_limits <double>::quiet_NaN ();
+        if (w000) {
+            summary->w000 = summary->w100 = summary->w200 = 0.;
+            for (int l = 0; l != num_labels; ++l) {
+                summary->w000 += w000->value (l);
+                summary->w100 += w100->value (l);
+                summary->w200 += w200->value (l);
+            }
+        }
+    }
+
+    save_functionals (funcs, output_prefix, what_to_compute, precision,
+                      num_labels);
+
+    if (!windows.empty ()) {
+        // the same once more as images
+        ScalarMinkowskiFunctional *all_sca[] = { w000, w100, w200 };
+        for (int i = 0; i != 3; ++i)
+            if (all_sca[i])
+                save_window_map (output_prefix + "window_map_" +
+                                 all_sca[i]->name () + ".out",
+                                 precision, *all_sca[i], "",
+                                 window_cols, window_rows);
+        MatrixMinkowskiFunctional *all_mat[] = { w020, w120, w102, w220, w211 };
+        for (int i = 0; i != 5; ++i)
+            if (all_mat[i]) {
+                std::string name = output_prefix + "window_map_" +
+                                   all_mat[i]->name ();
+                save_window_map (name + "_anisotropy.out", precision,
+                                 *all_mat[i], "anisotropy",
+                                 window_cols, window_rows);
+                save_window_map (name + "_angle.out", precision,
+                                 *all_mat[i], "angle",
+                                 window_cols, window_rows);
+            }
+    }
+}
+
+static
+std::vector <double> parse_thresholds (const std::string &list)
+{
+    // either first:last:step, or a comma separated list
+    std::vector <double> ret;
+    double first, last, step;
+    char c1, c2;
+    std::istringstream range (list);
+    if (range >> first >> c1 >> last >> c2 >> step && c1 == ':' && c2 == ':') {
+        if (! (step > 0.) || last < first)
+            die ("Invalid threshold range: %s", list.c_str ());
+        int n = int (floor ((last - first) / step + 1e-9)) + 1;
+        for (int i = 0; i != n; ++i)
+            ret.push_back (first + i * step);
+        return ret;
+    }
+    string_vector items = split_at_comma (list);
+    for (int i = 0; i != (int)items.size (); ++i) {
+        const char *begin = items[i].c_str ();
+        char *end;
+        ret.push_back (strtod (begin, &end));
+        if (end == begin || *end != '\0')
+            die ("Invalid threshold: \"%s\"", begin);
+    }
+    // each threshold has a directory of its own
+    std::vector <double> sorted (ret);
+    std::sort (sorted.begin (), sorted.end ());
+    std::vector <double>::const_iterator dup
+        = std::adjacent_find (sorted.begin (), sorted.end ());
+    if (dup != sorted.end ())
+        die ("Threshold %g given twice: %s", *dup, list.c_str ());
+    return ret;
+}
+
+// the fewest digits (but at least the default six) which tell all the
+// thresholds apart in the names of their directories
+static int threshold_precision (const std::vector <double> &thresholds) {
+    for (int precision = 6; precision != 17; ++precision) {
+        std::set <std::string> names;
+        for (int i = 0; i != (int)thresholds.size (); ++i) {
+            std::ostringstream name;
+            name << std::setprecision (precision) << thresholds[i];
+            names.insert (name.str ());
+        }
+        if (names.size () == thresholds.size ())
+            return precision;
+    }
+    return 17;
+}
+
+struct sweep_t {
+    const Configuration *conf;
+    const settings_t *settings;
+    const Pixmap *image;
+    const std::vector <double> *thresholds;
+    // of the threshold in the names of the directories
+    int precision;
+    // the next threshold to do, protected by the mutex
+    int next;
+    pthread_mutex_t mutex;
+};
+
+static void evaluate_threshold (const sweep_t *sweep, int i) {
+    settings_t settings = *sweep->settings;
+    settings.threshold = (*sweep->thresholds)[i];
+    std::ostringstream prefix;
+    prefix << settings.output_prefix << "threshold_"
+           << std::setprecision (sweep->precision) << settings.threshold << "/";
+    settings.output_prefix = prefix.str ();
+    prefix_mkdir (settings.output_prefix);
+    std::cerr << "[papaya] Threshold " << settings.threshold
+              << ", output prefix " << settings.output_prefix << "\n";
+    Boundary b;
+    evaluate (*sweep->conf, settings, b, sweep->image);
+}
+
+static void *sweep_thread (void *arg) {
+    sweep_t *sweep = (sweep_t *)arg;
+    for (;;) {
+        pthread_mutex_lock (&sweep->mutex);
+        int i = sweep->next++;
+        pthread_mutex_unlock (&sweep->mutex);
+        if (i >= (int)sweep->thresholds->size ())
+            return 0;
+        evaluate_threshold (sweep, i);
+    }
+}
+
+// evaluate all the thresholds.  with several threads, each of them takes
+// one threshold at a time and evaluates it with a single thread.
+static void threshold_sweep (const Configuration &conf,
+                             const settings_t &settings_,
+                             const Pixmap *image,
+                             const std::vector <double> &thresholds) {
+    settings_t settings = settings_;
+    int num_threads = std::min (settings.num_threads, int (thresholds.size ()));
+    if (num_threads > 1)
+        settings.num_threads = 1;
+    sweep_t sweep;
+    sweep.conf = &conf;
+    sweep.settings = &settings;
+    sweep.image = image;
+    sweep.thresholds = &thresholds;
+    sweep.precision = threshold_precision (thresholds);
+    sweep.next = 0;
+    pthread_mutex_init (&sweep.mutex, 0);
+    std::vector <pthread_t> threads (std::max (num_threads, 1));
+    for (int t = 1; t < num_threads; ++t)
+        if (pthread_create (&threads[t], 0, sweep_thread, &sweep))
+            die ("Unable to start thread");
+    sweep_thread (&sweep);
+    for (int t = 1; t < num_threads; ++t)
+        pthread_join (threads[t], 0);
+    pthread_mutex_destroy (&sweep.mutex);
+}
+
+// load the input file of settings->filename, and fill in the settings
+// of the segmentation.  polygons go into b, images into image unless
+// they are read while segmenting.
+static void load_input (const Configuration &conf, const std::string &format,
+                        double thresh_override, bool sweep, bool level_sets,
+                        settings_t *settings, Boundary *b, Pixmap *image) {
+    const std::string &filename = settings->filename;
+    if (format == "poly" || format == "bpoly") {
+        if (settings->fused)
+            die ("Fused and streaming mode are only possible for PGM and PBM input.");
+        if (sweep)
+            die ("--thresholds is not useful in .poly mode.");
+        if (thresh_override != -INFINITY)
+            die ("--threshold is not useful in .poly mode.");
+        if (format == "poly")
+            load_poly (b, filename, settings->num_threads);
+        else
+            load_bpoly (b, filename);
+        bool runfix   = conf.boolean ("polyinput", "fix_contours");
+        bool forceccw = conf.boolean ("polyinput", "force_counterclockwise");
+        if (runfix)
+            fix_contours (b, conf.boolean ("polyinput", "silent_fix_contours"));
+        if (forceccw)
+            force_counterclockwise_contours (b);
+    } else if (format == "pgm" || format == "pbm") {
+        settings->invert_image = conf.boolean ("segment", "invert");
+        settings->threshold  = conf.floating ("segment", "threshold");
+        if (thresh_override != -INFINITY)
+            settings->threshold = thresh_override;
+        settings->connectblack = conf.boolean ("segment", "connectblack");
+        settings->periodic_data = conf.boolean ("segment", "data_is_periodic");
+        settings->interpolate = conf.boolean ("segment", "interpolate", false);
+        if (settings->interpolate && level_sets)
+            die ("The level set sweep does not work with interpolation.");
+        if (!settings->streaming) {
+            load_pgm (image, filename, settings->num_threads);
+            if (settings->invert_image)
+                invert (image);
+        }
+    } else {
+        die ("only .pgm, .pbm, .poly and .bpoly files are valid input (\"%s\")",
+             filename.c_str ());
+    }
+}
+
+// one input of a batch run
+struct batch_input_t {
+    std::string filename;
+    std::string output_prefix;
+    // -INFINITY unless the manifest gives a threshold
+    double threshold;
+    // filled in when the input has been evaluated
+    bool failed;
+    std::string error;
+    summary_t summary;
+};
+
+// the output prefix of an input with none given: a directory named after
+// the file, below the output prefix
+static std::string batch_prefix (const std::string &output_prefix,
+                                 const std::string &filename) {
+    std::string name = filename.substr (filename.rfind ('/') + 1);
+    size_t dot = name.rfind ('.');
+    if (dot != std::string::npos && dot != 0)
+        name.erase (dot);
+    return output_prefix + name + "/";
+}
+
+// the inputs of a batch run.  a pattern with wildcards is expanded with
+// glob(3); anything else is a manifest with one input per line,
+//     filename [output_prefix|- [threshold]]
+// where blank lines and lines starting with # are skipped.
+static void read_batch_inputs (std::vector <batch_input_t> *inputs,
+                               const std::string &batch,
+                               const std::string &output_prefix) {
+    batch_input_t in;
+    in.threshold = -INFINITY;
+    in.failed = false;
+    if (batch.find_first_of ("*?[") != std::string::npos) {
+        glob_t g;
+        int err = glob (batch.c_str (), 0, 0, &g);
+        if (err && err != GLOB_NOMATCH)
+            die ("Unable to expand \"%s\"", batch.c_str ());
+        for (size_t i = 0; i != g.gl_pathc; ++i) {
+            in.filename = g.gl_pathv[i];
+            in.output_prefix = batch_prefix (output_prefix, in.filename);
+            inputs->push_back (in);
+        }
+        globfree (&g);
+    } else {
+        std::ifstream is (batch.c_str ());
+        if (!is)
+            die ("Unable to open the batch manifest \"%s\"", batch.c_str ());
+        std::string line;
+        for (int lineno = 1; std::getline (is, line); ++lineno) {
+            std::istringstream fields (line);
+            std::string prefix, thresh;
+            if (! (fields >> in.filename) || in.filename[0] == '#')
+                continue;
+            fields >> prefix >> thresh;
+            in.output_prefix = prefix.empty () || prefix == "-"
+                             ? batch_prefix (output_prefix, in.filename)
+                             : output_prefix + prefix;
+            in.threshold = -INFINITY;
+            if (!thresh.empty ()) {
+                char *end;
+                in.threshold = strtod (thresh.c_str (), &end);
+                if (*end != '\0')
+                    die ("%s:%i: invalid threshold \"%s\"", batch.c_str (),
+                         lineno, thresh.c_str ());
+            }
+            inputs->push_back (in);
+        }
+    }
+    if (inputs->empty ())
+        die ("No inputs in the batch \"%s\"", batch.c_str ());
+}
+
+struct batch_t {
+    const Configuration *conf;
+    const settings_t *settings;
+    const std::string *format;
+    double thresh_override;
+    std::vector <batch_input_t> *inputs;
+    // the next input to do, protected by the mutex
+    int next;
+    pthread_mutex_t mutex;
+};
+
+// load and evaluate one input.  the errors come as exceptions, so that
+// they only stop this input.
+static void evaluate_input (const batch_t *batch, batch_input_t *in) {
+    settings_t settings = *batch->settings;
+    settings.filename = in->filename;
+    settings.output_prefix = in->output_prefix;
+    double thresh_override = in->threshold != -INFINITY
+                           ? in->threshold : batch->thresh_override;
+    // a broken input must not end the whole run
+    DieThrows die_throws;
+    try {
+        std::string format = *batch->format;
+        if (format == "deduce_from_filename")
+            format = detect_fileformat (in->filename);
+        prefix_mkdir (settings.output_prefix);
+        std::cerr << "[papaya] Input " << in->filename
+                  << ", output prefix " << settings.output_prefix << "\n";
+        Boundary b;
+        Pixmap image;
+        load_input (*batch->conf, format, thresh_override, false, false,
+                    &settings, &b, &image);
+        const Pixmap *pixmap = format == "poly" || format == "bpoly"
+                               || settings.streaming ? 0 : &image;
+        evaluate (*batch->conf, settings, b, pixmap, &in->summary);
+    } catch (std::exception &e) {
+        in->failed = true;
+        in->error = e.what ();
+        std::cerr << "[papaya] FAILED " << in->filename << ": " << e.what () << "\n";
+    }
+}
+
+static void *batch_thread (void *arg) {
+    batch_t *batch = (batch_t *)arg;
+    for (;;) {
+        pthread_mutex_lock (&batch->mutex);
+        int i = batch->next++;
+        pthread_mutex_unlock (&batch->mutex);
+        if (i >= (int)batch->inputs->size ())
+            return 0;
+        evaluate_input (batch, &(*batch->inputs)[i]);
+    }
+}
+
+// one line per input with the totals over its labels
+static void save_batch_summary (const std::string &filename, int precision,
+                                const std::vector <batch_input_t> &inputs) {
+    std::ofstream of (filename.c_str ());
+    if (!of)
+        die ("Unable to open \"%s\"", filename.c_str ());
+    of << "#   1 input\t  2 status\t  3 threshold\t  4 labels"
+          "\t  5 w000\t  6 w100\t  7 w200\t  8 filename\t  9 prefix\n";
+    of << std::setprecision (precision);
+    for (size_t i = 0; i != inputs.size (); ++i) {
+        const batch_input_t &in = inputs[i];
+        of << i << "\t" << (in.failed ? "failed" : "ok");
+        if (in.failed)
+            of << "\tnan\t0\tnan\tnan\tnan";
+        else
+            of << "\t" << in.summary.threshold << "\t" << in.summary.num_labels
+               << "\t" << in.summary.w000 << "\t" << in.summary.w100
+               << "\t" << in.summary.w200;
+        of << "\t" << in.filename << "\t" << in.output_prefix << "\n";
+    }
+}
+
+// evaluate all the inputs of a batch.  like the threshold sweep, each
+// thread takes one input at a time and evaluates it with a single
+// thread, so that only one input per thread is held in memory.  the
+// return value is the exit status: 1 if any input failed.
+static int process_batch (const Configuration &conf,
+                          const settings_t &settings_,
+                          const std::string &format, const std::string &list,
+                          double thresh_override, bool summary) {
+    std::vector <batch_input_t> inputs;
+    read_batch_inputs (&inputs, list, settings_.output_prefix);
+    std::cerr << "[papaya] " << inputs.size () << " inputs in the batch\n";
+    settings_t settings = settings_;
+    int num_threads = std::min (settings.num_threads, int (inputs.size ()));
+    // the inputs are always evaluated with a single thread, even if
+    // there are fewer inputs than threads: die () only throws in the
+    // thread evaluating the input, not in threads started from there.
+    settings.num_threads = 1;
+    batch_t batch;
+    batch.conf = &conf;
+    batch.settings = &settings;
+    batch.format = &format;
+    batch.thresh_override = thresh_override;
+    batch.inputs = &inputs;
+    batch.next = 0;
+    pthread_mutex_init (&batch.mutex, 0);
+    std::vector <pthread_t> threads (std::max (num_threads, 1));
+    for (int t = 1; t < num_threads; ++t)
+        if (pthread_create (&threads[t], 0, batch_thread, &batch))
+            die ("Unable to start thread");
+    batch_thread (&batch);
+    for (int t = 1; t < num_threads; ++t)
+        pthread_join (threads[t], 0);
+    pthread_mutex_destroy (&batch.mutex);
+
+    int num_failed = 0;
+    for (size_t i = 0; i != inputs.size (); ++i)
+        num_failed += inputs[i].failed;
+    if (summary)
+        save_batch_summary (settings.output_prefix + "batch_summary.out",
+                            settings.precision, inputs);
+    std::cerr << "[papaya] " << inputs.size () - num_failed << " of "
+              << inputs.size () << " inputs done";
+    if (num_failed)
+        std::cerr << ", " << num_failed << " failed";
+    std::cerr << "\n";
+    return num_failed ? 1 : 0;
+}
+
+// the gigantic main function of the program.
+int main (int argc, char **argv) {
+    GetOpt_pp ops (argc, argv);
+
+    if (ops >> OptionPresent ('v', "version")) {
+        std::cerr << "papaya " << VERSION << "\n";
+        return 0;
+    }
+
+    // preparing the config file, and the command line.
+    std::string configfile = my_basename (argv[0]) + ".conf";
+    if (ops >> OptionPresent ('c', "config")) {
+        ops >> Option ('c', "config", configfile);
+    }
+    std::cerr << "[papaya] Using config file " << configfile << "\n";
+    Configuration conf (configfile);
+
+    // in batch mode, the input files are listed in a manifest or given
+    // by a glob pattern, and [input] filename is not used
+    std::string batch = conf.string ("batch", "inputs", "");
+    if (ops >> OptionPresent ('\0', "batch"))
+        ops >> Option ('\0', "batch", batch);
+    bool summary = conf.boolean ("batch", "summary", false);
+    if (ops >> OptionPresent ('\0', "summary"))
+        summary = true;
+
+    std::string filename = batch.empty () ? conf.string ("input", "filename") : "";
+    std::string in_fileformat = conf.string ("input", "format", "deduce_from_filename");
+    if (ops >> OptionPresent ('i', "input"))
+        // override the input specified in config file
+        ops >> Option ('i', "input", filename);
+    if (ops >> OptionPresent ('F', "format"))
+        ops >> Option ('F', "format", in_fileformat);
+    if (!batch.empty ()) {
+        std::cerr << "[papaya] Batch of inputs " << batch << "\n";
+    } else {
+        if (in_fileformat == "deduce_from_filename")
+            in_fileformat = detect_fileformat (filename);
+        std::cerr << "[papaya] Using input file " << filename << "\n";
+    }
+
+    std::string output_prefix = conf.string ("output", "prefix");
+    if (ops >> OptionPresent ('o', "output")) {
+        // override the output specified in config file
+        ops >> Option ('o', "output", output_prefix);
+    }
+    std::cerr << "[papaya] Using output prefix " << output_prefix << "\n";
+    if (conf.boolean ("output", "mkdir", false))
+        prefix_mkdir (output_prefix);
+
+    double thresh_override = -INFINITY;
+    if (ops >> OptionPresent ('\0', "threshold")) {
+        ops >> Option ('\0', "threshold", thresh_override);
+        std::cerr << "[papaya] Using threshold " << thresh_override << "\n";
+    }
+
+    int precision = conf.integer ("output", "precision");
+
+    // 0 means one thread per CPU
+    int num_threads = conf.integer ("performance", "threads", 1);
+    if (ops >> OptionPresent ('\0', "threads"))
+        ops >> Option ('\0', "threads", num_threads);
+    if (num_threads == 0)
+        num_threads = num_online_cpus ();
+    if (num_threads < 0)
+        die ("Invalid number of threads: %i", num_threads);
+    if (num_threads > 1)
+        std::cerr << "[papaya] Using " << num_threads << " threads\n";
+
+    std::string normalization = conf.string ("output", "normalization", "code_default");
+    if (ops >> OptionPresent ('N', "normalization"))
+        ops >> Option ('N', "normalization", normalization);
+    if (normalization == "breidenbach") {
+        W0_NORMALIZATION = W1_NORMALIZATION = W2_NORMALIZATION = 1.;
+    } else if (normalization == "new") {
+        W0_NORMALIZATION = 1.;
+        W1_NORMALIZATION = W2_NORMALIZATION = .5;
+    } else if (normalization == "code_default") {
+    } else {
+        std::cerr << "Invalid normalization setting: " << normalization << std::endl;
+        return 1;
+    }
+
+    // in fused mode, the contours go straight from marching squares into
+    // the functionals, and b stays empty.  in streaming mode, the image
+    // is also segmented while it is read.
+    bool fused = conf.boolean ("segment", "fused", false);
+    if (ops >> OptionPresent ('\0', "fused"))
+        fused = true;
+    bool streaming = conf.boolean ("segment", "streaming", false);
+    if (ops >> OptionPresent ('\0', "stream"))
+        streaming = true;
+    if (streaming)
+        fused = true;
+
+    // a threshold sweep loads the image only once, and writes the
+    // results for each threshold to a directory of its own.
+    std::string thresholds_list = conf.string ("segment", "thresholds", "");
+    if (ops >> OptionPresent ('\0', "thresholds"))
+        ops >> Option ('\0', "thresholds", thresholds_list);
+    std::vector <double> thresholds;
+    if (!thresholds_list.empty ()) {
+        if (thresh_override != -INFINITY)
+            die ("--threshold and --thresholds cannot be used together.");
+        thresholds = parse_thresholds (thresholds_list);
+    }
+    // only the scalar functionals of the whole image, for all thresholds
+    // in a single pass
+    bool level_sets = conf.boolean ("segment", "level_set_sweep", false);
+    if (ops >> OptionPresent ('\0', "level-sets"))
+        level_sets = true;
+    if (level_sets && (thresholds.empty () || fused))
+        die ("The level set sweep needs --thresholds, and does not work in "
+             "fused or streaming mode.");
+
+    // find out what we're supposed to compute
+    std::string default_what = "contours,labels,scalars,vectors,tensors";
+    settings_t settings;
+    string_vector &what_to_compute = settings.what_to_compute;
+    what_to_compute =
+        parse_what_to_compute (conf.string ("output", "compute", default_what));
+    if (ops >> OptionPresent (' ', "compute")) {
+        std::string what;
+        ops >> Option (' ', "compute", what);
+        what_to_compute = parse_what_to_compute (what);
+    }
+    if (fused && (vector_contains (what_to_compute, "contours") ||
+                  vector_contains (what_to_compute, "boundary") ||
+                  vector_contains (what_to_compute, "labels"))) {
+        std::cerr << "[papaya] Not writing contours and labels in fused mode\n";
+        what_to_compute.erase (std::remove (what_to_compute.begin (),
+                                            what_to_compute.end (),
+                                            std::string ("boundary")),
+                               what_to_compute.end ());
+        what_to_compute.erase (std::remove (what_to_compute.begin (),
+                                            what_to_compute.end (),
+                                            std::string ("contours")),
+                               what_to_compute.end ());
+        what_to_compute.erase (std::remove (what_to_compute.begin (),
+                                            what_to_compute.end (),
+                                            std::string ("labels")),
+                               what_to_compute.end ());
+    }
+
+
+    settings.filename = filename;
+    settings.output_prefix = output_prefix;
+    settings.precision = precision;
+    settings.num_threads = num_threads;
+    settings.fused = fused;
+    settings.streaming = streaming;
+    // the segmentation settings are read by load_input
+    settings.threshold = 0.;
+    settings.invert_image = false;
+    settings.connectblack = false;
+    settings.periodic_data = false;
+    settings.interpolate = false;
+
+    if (!batch.empty ()) {
+        if (!thresholds.empty () || level_sets)
+            die ("--batch does not work with --thresholds or --level-sets.");
+        return process_batch (conf, settings, in_fileformat, batch,
+                              thresh_override, summary);
+    }
+
+    Boundary b;
+    // the image, unless it is read while segmenting
+    Pixmap image;
+    load_input (conf, in_fileformat, thresh_override, !thresholds.empty (),
+                level_sets, &settings, &b, &image);
+    const Pixmap *pixmap = in_fileformat == "poly" || in_fileformat == "bpoly"
+                           || streaming ? 0 : &image;
+
+    if (level_sets)
+        save_level_sets (output_prefix + "level_sets.out", precision, image,
+                         thresholds, settings.connectblack,
+                         settings.periodic_data);
+    else if (thresholds.empty ())
+        evaluate (conf, settings, b, pixmap);
+    else
+        threshold_sweep (conf, settings, pixmap, thresholds);
 
     return 0;
 }
@@ -1,5 +1,6 @@
 // vim:et:sw=4:ts=4
-// simple N^2 intersection algorithm
+// simple N^2 intersection algorithm, and a faster one using a grid
+// over the edges which gives the same results.
 // it is tricky in a few points to make the algorithm
 // return consistent results, i.e. that every closed contour
 // has an even number of intersects with a test ray.
@@ -17,6 +18,7 @@
 // + 0 0 0 0 +         0 intersects
 
 #include "intersect.h"
+#include <math.h>
 
 namespace
 {
@@ -141,6 +143,12 @@ namespace
             find_intersecting_edges (st, b, cit, r0, dir_);
     }
 
+    static
+    int vertex_sign (const vec_t &v, const vec_t &cdir_, double offset)
+    {
+        return int (sgn (dot (v, cdir_) - offset));
+    }
+
     class IntersectCollector : public intersect_buffer_t
     {
     public:
@@ -183,12 +191,188 @@ namespace
     }
 }
 
+EdgeGrid::EdgeGrid (const Boundary &b)
+    : my_b (b), my_query (0) {
+    assert_complete_boundary (b);
+    double x1 = -INFINITY, y1 = -INFINITY;
+    my_x0 = my_y0 = INFINITY;
+    Boundary::contour_iterator cit;
+    Boundary::edge_iterator eit;
+    for (cit = b.contours_begin (); cit != b.contours_end (); ++cit) {
+        my_contour_begin.push_back ((int)my_edge.size ());
+        for (eit = b.edges_begin (cit); eit != b.edges_end (cit); ++eit) {
+            my_contour.push_back ((int)my_contour_begin.size () - 1);
+            my_edge.push_back (eit);
+            const vec_t v = b.edge_vertex0 (eit);
+            my_x0 = std::min (my_x0, v[0]);
+            my_y0 = std::min (my_y0, v[1]);
+            x1 = std::max (x1, v[0]);
+            y1 = std::max (y1, v[1]);
+        }
+    }
+    my_contour_begin.push_back ((int)my_edge.size ());
+    const int n = (int)my_edge.size ();
+    if (!n)
+        my_x0 = my_y0 = x1 = y1 = 0.;
+
+    // about one edge per cell, and not too many cells along a narrow
+    // bounding box
+    const double w = x1 - my_x0, h = y1 - my_y0;
+    my_cell_size = std::max (sqrt (w * h / std::max (n, 1)),
+                             std::max (w, h) / std::max (n, 1));
+    if (!(my_cell_size > 0.))
+        my_cell_size = 1.;
+    my_nx = int (w / my_cell_size) + 1;
+    my_ny = int (h / my_cell_size) + 1;
+
+    // sort the edges into the cells their bounding boxes overlap
+    my_cell_begin.assign (my_nx * my_ny + 1, 0);
+    for (int pass = 0; pass != 2; ++pass) {
+        for (int e = 0; e != n; ++e) {
+            const vec_t v0 = b.edge_vertex0 (my_edge[e]);
+            const vec_t v1 = b.edge_vertex1 (my_edge[e]);
+            const int i0 = int ((std::min (v0[0], v1[0]) - my_x0) / my_cell_size);
+            const int i1 = int ((std::max (v0[0], v1[0]) - my_x0) / my_cell_size);
+            const int j0 = int ((std::min (v0[1], v1[1]) - my_y0) / my_cell_size);
+            const int j1 = int ((std::max (v0[1], v1[1]) - my_y0) / my_cell_size);
+            for (int j = j0; j <= j1; ++j)
+            for (int i = i0; i <= i1; ++i) {
+                if (pass == 0)
+                    ++my_cell_begin[j*my_nx + i + 1];
+                else
+                    my_cell_edges[my_cell_begin[j*my_nx + i]++] = e;
+            }
+        }
+        if (pass == 0) {
+            for (int c = 0; c != my_nx * my_ny; ++c)
+                my_cell_begin[c+1] += my_cell_begin[c];
+            my_cell_edges.resize (my_cell_begin.back ());
+        } else {
+            // the fill pass has moved each start to the next one
+            for (int c = my_nx * my_ny; c != 0; --c)
+                my_cell_begin[c] = my_cell_begin[c-1];
+            my_cell_begin[0] = 0;
+        }
+    }
+    my_seen.assign (n, 0);
+}
+
+struct EdgeGridQuery
+{
+    // find the edges in the cells along the line (or the ray), and
+    // store the intersections exactly as find_intersecting_edges walks
+    // the contours: an edge is crossed if its second vertex is off the
+    // line, and the last vertex before it which is off the line is on
+    // the other side.
+    template <typename STORE>
+    static
+    void find_intersections (
+        STORE *st, const EdgeGrid &g,
+        const vec_t &r0, const vec_t &dir_, bool ray)
+    {
+        const Boundary &b = g.my_b;
+        const vec_t cdir_ = rot90_ccw (dir_);
+        const double offset = dot (cdir_, r0);
+        const double s = g.my_cell_size;
+        // the cells near the line are visited as well, in case of
+        // rounding
+        const double margin = 1e-6 * s +
+            1e-12 * (fabs (g.my_x0) + fabs (g.my_y0) + s * (g.my_nx + g.my_ny));
+        const double dir_len = sqrt (dot (dir_, dir_));
+        ++g.my_query;
+
+        std::vector <int> candidates;
+        for (int j = 0; j != g.my_ny; ++j) {
+            const double ylo = g.my_y0 + j * s - margin;
+            const double yhi = g.my_y0 + (j+1) * s + margin;
+            // range of the line parameter within this row of cells
+            double tlo = -INFINITY, thi = INFINITY;
+            if (dir_[1] != 0.) {
+                tlo = (ylo - r0[1]) / dir_[1];
+                thi = (yhi - r0[1]) / dir_[1];
+                if (tlo > thi)
+                    std::swap (tlo, thi);
+            } else if (r0[1] < ylo || r0[1] > yhi) {
+                continue;
+            }
+            if (ray)
+                tlo = std::max (tlo, -margin / dir_len);
+            if (!(tlo <= thi))
+                continue;
+            double xa = r0[0], xb = r0[0];
+            if (dir_[0] != 0.) {
+                xa = r0[0] + tlo * dir_[0];
+                xb = r0[0] + thi * dir_[0];
+                if (xa > xb)
+                    std::swap (xa, xb);
+            }
+            const double ia = (xa - margin - g.my_x0) / s;
+            const double ib = (xb + margin - g.my_x0) / s;
+            if (ib < 0. || ia >= g.my_nx)
+                continue;
+            const int i0 = ia < 0. ? 0 : int (ia);
+            const int i1 = ib >= g.my_nx ? g.my_nx - 1 : int (ib);
+            for (int c = j * g.my_nx + i0; c <= j * g.my_nx + i1; ++c)
+            for (int k = g.my_cell_begin[c]; k != g.my_cell_begin[c+1]; ++k) {
+                const int e = g.my_cell_edges[k];
+                if (g.my_seen[e] != g.my_query) {
+                    g.my_seen[e] = g.my_query;
+                    candidates.push_back (e);
+                }
+            }
+        }
+
+        // (contour, position in the walk), edge, sign
+        typedef std::pair <std::pair <int, int>, std::pair <int, int> > hit_t;
+        std::vector <hit_t> hits;
+        for (size_t i = 0; i != candidates.size (); ++i) {
+            const int e = candidates[i];
+            const int c = g.my_contour[e];
+            const int cb = g.my_contour_begin[c], ce = g.my_contour_begin[c+1];
+            const int sign1 = vertex_sign (b.edge_vertex1 (g.my_edge[e]), cdir_, offset);
+            if (sign1 == 0)
+                continue;
+            int k = e, sign0;
+            while ((sign0 = vertex_sign (b.edge_vertex0 (g.my_edge[k]), cdir_, offset)) == 0)
+                k = (k == cb ? ce : k) - 1;
+            if (sign0 == sign1)
+                continue;
+            // the walk starts at the first vertex off the line
+            int a = cb;
+            while (vertex_sign (b.edge_vertex0 (g.my_edge[a]), cdir_, offset) == 0)
+                ++a;
+            const int pos = (e - a + (ce - cb)) % (ce - cb);
+            hits.push_back (hit_t (std::make_pair (c, pos), std::make_pair (e, sign1)));
+        }
+        std::sort (hits.begin (), hits.end ());
+        for (size_t i = 0; i != hits.size (); ++i) {
+            const int e = hits[i].second.first;
+            const int c = g.my_contour[e], cb = g.my_contour_begin[c];
+            Boundary::edge_iterator eit = g.my_edge[e];
+            if (hits[i].first.second > e - cb) {
+                // the walk got there after wrapping around, which the
+                // iterator remembers
+                eit = g.my_edge[g.my_contour_begin[c+1] - 1];
+                for (int k = cb; k <= e; ++k)
+                    ++eit;
+            }
+            intersect_info_t info;
+            compute_intersection_point (&info, b, eit, r0, dir_);
+            info.sign = hits[i].second.second;
+            (*st)(info);
+        }
+    }
+};
+
 unsigned
 intersect_line_boundary (intersect_buffer_t *dst,
                          const vec_t &line_0, const vec_t &line_dir,
-                         Boundary *b)  {
+                         Boundary *b, const EdgeGrid *grid)  {
     IntersectCollector st (dst);
-    find_intersections (&st, *b, line_0, line_dir);
+    if (grid)
+        EdgeGridQuery::find_intersections (&st, *grid, line_0, line_dir, false);
+    else
+        find_intersections (&st, *b, line_0, line_dir);
     sort_intersections (dst);
     return (int)dst->size ();
 }
@@ -196,14 +380,45 @@ intersect_line_boundary (intersect_buffer_t *dst,
 unsigned
 intersect_ray_boundary (intersect_buffer_t *dst,
                         const vec_t &line_0, const vec_t &line_dir,
-                        Boundary *b)  {
+                        Boundary *b, const EdgeGrid *grid)  {
     RayIntersectCollector st (dst);
-    find_intersections (&st, *b, line_0, line_dir);
+    if (grid)
+        EdgeGridQuery::find_intersections (&st, *grid, line_0, line_dir, true);
+    else
+        find_intersections (&st, *b, line_0, line_dir);
     sort_intersections (dst);
     return (int)dst->size ();
 }
 
-
+unsigned
+intersect_line_edges (intersect_buffer_t *dst,
+                      const vec_t &line_0, const vec_t &line_dir,
+                      const Boundary &b,
+                      const std::vector <Boundary::edge_iterator> &edges)  {
+    IntersectCollector st (dst);
+    const vec_t cdir_ = rot90_ccw (line_dir);
+    const double offset = dot (cdir_, line_0);
+    for (size_t i = 0; i != edges.size (); ++i) {
+        // the same rule as in find_intersecting_edges: the second vertex
+        // is off the line, and the last vertex before it which is off the
+        // line is on the other side.
+        const int sign1 = vertex_sign (b.edge_vertex1 (edges[i]), cdir_, offset);
+        if (sign1 == 0)
+            continue;
+        Boundary::edge_iterator it = edges[i];
+        int sign0;
+        while ((sign0 = vertex_sign (b.edge_vertex0 (it), cdir_, offset)) == 0)
+            --it;
+        if (sign0 == sign1)
+            continue;
+        intersect_info_t info;
+        compute_intersection_point (&info, b, edges[i], line_0, line_dir);
+        info.sign = sign1;
+        st (info);
+    }
+    sort_intersections (dst);
+    return (int)dst->size ();
+}
 
 // implement assert_complete_boundary
 
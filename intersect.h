@@ -22,15 +22,53 @@ typedef std::vector <intersect_info_t> intersect_buffer_t;
 // save the intersect points to a GNUPLOT-readable format
 void dump_intersect_buffer (std::ostream &, const intersect_buffer_t &);
 
+// a uniform grid over the edges of a Boundary, so that intersecting
+// a line only looks at the edges near it.  the grid has to be built
+// again when the edges of the boundary change (labels may change).
+// queries are not thread-safe.
+class EdgeGrid {
+public:
+    explicit EdgeGrid (const Boundary &);
+
+private:
+    friend struct EdgeGridQuery;
+    const Boundary &my_b;
+    // the edges in the order of the contours, each contour starting at
+    // edges_begin; edge i belongs to contour my_contour[i], which
+    // occupies [my_contour_begin[c], my_contour_begin[c+1]).
+    std::vector <Boundary::edge_iterator> my_edge;
+    std::vector <int> my_contour, my_contour_begin;
+    // the edges overlapping cell (i,j) are
+    // my_cell_edges[my_cell_begin[j*my_nx+i] ... my_cell_begin[j*my_nx+i+1]).
+    double my_x0, my_y0, my_cell_size;
+    int my_nx, my_ny;
+    std::vector <int> my_cell_begin, my_cell_edges;
+    // the number of the last query each edge was found in
+    mutable std::vector <int> my_seen;
+    mutable int my_query;
+};
+
+// with a grid, only the edges near the line are tested; the result is
+// the same.
 unsigned
 int  intersect_ray_boundary (intersect_buffer_t *,
                              const vec_t &ray_0, const vec_t &ray_dir,
-                             Boundary *);
+                             Boundary *, const EdgeGrid * = 0);
 
 unsigned
 int intersect_line_boundary (intersect_buffer_t *,
                              const vec_t &r0, const vec_t &dir,
-                             Boundary *);
+                             Boundary *, const EdgeGrid * = 0);
+
+// only the given edges are tested, which have to include all the edges
+// reaching the line.  the intersections are the same as with
+// intersect_line_boundary, except that coinciding ones may come in a
+// different order.
+unsigned
+int intersect_line_edges (intersect_buffer_t *,
+                          const vec_t &r0, const vec_t &dir,
+                          const Boundary &,
+                          const std::vector <Boundary::edge_iterator> &);
 
 bool intersect_vertex_rect (const vec_t &v, const rect_t &r);
 
@@ -3,6 +3,7 @@
 
 #include "util.h"
 #include "intersect.h"
+#include <set>
 
 // update the label of each edge on the contour to be "label"
 static void relabel_contour (Boundary *b, Boundary::contour_iterator cit, int label) {
@@ -41,7 +42,266 @@ namespace {
     }
 }
 
-int label_by_component (Boundary *b)
+namespace {
+    // an edge which is not horizontal, from its lower vertex upwards
+    struct sweep_edge_t {
+        double x0, y0, y1, dxdy;
+        int contour;
+        bool upward;
+    };
+
+    // orders the edges crossing the sweep line by their x coordinate just
+    // above it.  this stays valid while the sweep line moves up as long as
+    // the edges do not intersect.
+    class SweepOrder {
+    public:
+        SweepOrder (const std::vector <sweep_edge_t> &edges, const double &y)
+            : my_edges (&edges), my_y (&y) { }
+
+        bool operator() (int a, int b) const {
+            const sweep_edge_t &ea = (*my_edges)[a], &eb = (*my_edges)[b];
+            const double xa = ea.x0 + (*my_y - ea.y0) * ea.dxdy;
+            const double xb = eb.x0 + (*my_y - eb.y0) * eb.dxdy;
+            if (xa != xb)
+                return xa < xb;
+            return ea.dxdy < eb.dxdy;
+        }
+
+    private:
+        const std::vector <sweep_edge_t> *my_edges;
+        const double *my_y;
+    };
+
+    // at the same height, edges are removed before new ones are inserted,
+    // and the queries come last
+    struct sweep_event_t {
+        enum { REMOVE, INSERT, QUERY };
+        double y;
+        int type, index;
+
+        sweep_event_t (double y_, int type_, int index_)
+            : y (y_), type (type_), index (index_) { }
+
+        bool operator< (const sweep_event_t &other) const {
+            if (y != other.y)
+                return y < other.y;
+            if (type != other.type)
+                return type < other.type;
+            return index < other.index;
+        }
+    };
+
+    // the leftmost, then lowest vertex comes first
+    struct LeftmostOrder {
+        LeftmostOrder (const std::vector <vec_t> &v) : my_v (&v) { }
+
+        bool operator() (int a, int b) const {
+            const vec_t &va = (*my_v)[a], &vb = (*my_v)[b];
+            return va[0] != vb[0] ? va[0] < vb[0] : va[1] < vb[1];
+        }
+
+        const std::vector <vec_t> *my_v;
+    };
+}
+
+// assign each clockwise contour the label of the counterclockwise contour
+// around it, from the nesting tree of all the contours.  the tree is built
+// by sweeping a horizontal line upward over the edges, and looking for the
+// nearest edge to the left of the leftmost vertex of each contour: the
+// space between them is outside the contour, so if the edge belongs to a
+// contour of the other orientation, that contour is the parent, otherwise
+// it is a sibling.  returns false without changing any labels if the
+// contours do not nest properly.
+static bool assign_cavities_by_sweep (Boundary *b, const std::vector <int> &ccw)
+{
+    std::vector <Boundary::contour_iterator> contour;
+    std::vector <vec_t> leftmost;
+    std::vector <sweep_edge_t> edges;
+    Boundary::contour_iterator cit;
+    Boundary::edge_iterator eit;
+    for (cit = b->contours_begin (); cit != b->contours_end (); ++cit) {
+        vec_t left = b->edge_vertex0 (b->edges_begin (cit));
+        for (eit = b->edges_begin (cit); eit != b->edges_end (cit); ++eit) {
+            const vec_t v0 = b->edge_vertex0 (eit), v1 = b->edge_vertex1 (eit);
+            if (v0[0] < left[0] || (v0[0] == left[0] && v0[1] < left[1]))
+                left = v0;
+            // horizontal edges never cross the sweep line
+            if (v0[1] == v1[1])
+                continue;
+            const vec_t &lo = v0[1] < v1[1] ? v0 : v1;
+            const vec_t &hi = v0[1] < v1[1] ? v1 : v0;
+            sweep_edge_t e;
+            e.x0 = lo[0];
+            e.y0 = lo[1];
+            e.y1 = hi[1];
+            e.dxdy = (hi[0] - lo[0]) / (hi[1] - lo[1]);
+            e.contour = (int)contour.size ();
+            e.upward = v1[1] > v0[1];
+            edges.push_back (e);
+        }
+        contour.push_back (cit);
+        leftmost.push_back (left);
+    }
+    const int num_contours = (int)contour.size ();
+    const int num_edges = (int)edges.size ();
+
+    std::vector <sweep_event_t> events;
+    events.reserve (2 * num_edges + num_contours);
+    for (int i = 0; i != num_edges; ++i) {
+        events.push_back (sweep_event_t (edges[i].y0, sweep_event_t::INSERT, i));
+        events.push_back (sweep_event_t (edges[i].y1, sweep_event_t::REMOVE, i));
+    }
+    for (int k = 0; k != num_contours; ++k)
+        events.push_back (sweep_event_t (leftmost[k][1], sweep_event_t::QUERY, k));
+    std::sort (events.begin (), events.end ());
+
+    // the queries are compared as a vertical edge, which goes into the
+    // last slot
+    edges.push_back (sweep_edge_t ());
+    sweep_edge_t &query = edges.back ();
+    query.dxdy = 0.;
+    double y = 0.;
+    typedef std::set <int, SweepOrder> active_t;
+    active_t active (SweepOrder (edges, y));
+    std::vector <active_t::iterator> where (num_edges);
+    // the edge next to the left of each contour
+    std::vector <int> west (num_contours, -1);
+    for (size_t i = 0; i != events.size (); ++i) {
+        const sweep_event_t &ev = events[i];
+        y = ev.y;
+        if (ev.type == sweep_event_t::REMOVE) {
+            active.erase (where[ev.index]);
+        } else if (ev.type == sweep_event_t::INSERT) {
+            std::pair <active_t::iterator, bool> ins = active.insert (ev.index);
+            // overlapping edges
+            if (!ins.second)
+                return false;
+            where[ev.index] = ins.first;
+        } else {
+            query.x0 = leftmost[ev.index][0];
+            query.y0 = y;
+            active_t::iterator it = active.lower_bound (num_edges);
+            if (it != active.begin ())
+                west[ev.index] = *--it;
+        }
+    }
+
+    // the contour to the left has a vertex further to the left, so its
+    // parent is known when going from left to right.
+    std::vector <int> order (num_contours);
+    for (int k = 0; k != num_contours; ++k)
+        order[k] = k;
+    std::sort (order.begin (), order.end (), LeftmostOrder (leftmost));
+    std::vector <int> parent (num_contours, -1);
+    std::vector <bool> done (num_contours, false);
+    for (int i = 0; i != num_contours; ++i) {
+        const int k = order[i];
+        const bool is_ccw = ccw.at (*contour[k]);
+        done[k] = true;
+        if (west[k] == -1) {
+            // cavities have to be inside something
+            if (!is_ccw)
+                return false;
+            continue;
+        }
+        const sweep_edge_t &e = edges[west[k]];
+        // outside of a ccw contour is void, which lies to the right of an
+        // upward edge
+        if (e.upward != is_ccw || e.contour == k || !done[e.contour])
+            return false;
+        parent[k] = (bool)ccw.at (*contour[e.contour]) == is_ccw
+                  ? parent[e.contour] : e.contour;
+        if (!is_ccw && parent[k] == -1)
+            return false;
+    }
+
+    for (int k = 0; k != num_contours; ++k)
+        if (!ccw.at (*contour[k]))
+            relabel_contour (b, contour[k],
+                b->edge_label (b->edges_begin (contour[parent[k]])));
+    return true;
+}
+
+// assign each clockwise contour the label of the closest counterclockwise
+// contour around it, which is found by casting a ray outward from the
+// contour.  this costs one ray per cavity, but copes with contours which
+// do not nest properly.
+static void assign_cavities_by_rays (Boundary *b, const std::vector <int> &ccw)
+{
+    // relabelling leaves the edges alone, so one grid does for all rays
+    EdgeGrid grid (*b);
+    Boundary::contour_iterator cit;
+    for (cit = b->contours_begin (); cit != b->contours_end (); ++cit) {
+        int ccwflag = ccw.at (*cit);
+        assert (ccwflag == 0 || ccwflag == 1);
+        if (!ccwflag) {
+            // is clockwise
+            vec_t ray_begin = b->edge_vertex0 (b->edges_begin (cit));
+            vec_t ray_direction = b->edge_normal (b->edges_begin (cit));
+            intersect_buffer_t info;
+            intersect_ray_boundary (&info,
+                ray_begin, ray_direction,
+                b, &grid);
+            // the buffer now contains a lot of intersections,
+            // most of which are useless because they are caused by
+            // * this contour
+            // * other clockwise contours
+            // * ccw contours which do not enclose this contour
+            //   (e.g. enclosed interior components)
+            // * ccw contours which do enclose this contour but are not the
+            //   closest match
+
+            // sort the hits so hits in the same contour are adjacent
+            std::sort (info.begin (), info.end (), intersect_info_t::by_contour_id);
+            intersect_buffer_t::iterator it = info.begin ();
+            intersect_info_t *found_ = 0;
+            while (it != info.end ()) {
+                int this_contour;
+
+                intersect_buffer_t::iterator it_up =
+                    std::upper_bound (it+1, info.end (), *it,
+                        intersect_info_t::by_contour_id);
+                // ignore even contours
+                int num_hits = it_up - it;
+                if (even (num_hits))
+                    goto next_intersect;
+                // ignore cw contours.
+                // [the contour we're processing is cw too, so self-intersects
+                //  will be detected here]
+                this_contour = it->iedge->contour;
+                if (!ccw[this_contour])
+                    goto next_intersect;
+                // find closest match in this contour
+                {
+                    intersect_buffer_t::iterator it_candidate =
+                        std::min_element (it, it_up,
+                                intersect_info_t::by_normal_coordinate);
+                    if (found_) {
+                        if (found_->inc > it_candidate->inc)
+                            found_ = &*it_candidate;
+                    } else {
+                        found_ = &*it_candidate;
+                    }
+                }
+            next_intersect:
+                it = it_up;
+            }
+
+            if (found_) {
+                relabel_contour (b, cit, found_->iedge->label);
+                goto next_contour;
+            }
+
+            // we hit the outer boundary without finding a ccw contour.
+            // most probably, this is a user error.
+            die ("label_by_component: hit dataset boundary while searching for exterior boundary. "
+                 "most probably, your polygons' vertices are in inverse order.");
+        }
+    next_contour:;
+    }
+}
+
+int label_by_component (Boundary *b, bool by_sweep)
 {
     // find clockwise contours which correspond to
     // interior boundary segments. these are assigned to the
@@ -68,86 +328,72 @@ int label_by_component (Boundary *b)
     }
     {
         // step 2
-        Boundary::contour_iterator cit;
-        for (cit = b->contours_begin (); cit != b->contours_end (); ++cit) {
-            int ccwflag = ccw.at (*cit);
-            assert (ccwflag == 0 || ccwflag == 1);
-            if (!ccwflag) {
-                // is clockwise
-                vec_t ray_begin = b->edge_vertex0 (b->edges_begin (cit));
-                vec_t ray_direction = b->edge_normal (b->edges_begin (cit));
-                intersect_buffer_t info;
-                intersect_ray_boundary (&info,
-                    ray_begin, ray_direction,
-                    b);
-                // the buffer now contains a lot of intersections,
-                // most of which are useless because they are caused by
-                // * this contour
-                // * other clockwise contours
-                // * ccw contours which do not enclose this contour
-                //   (e.g. enclosed interior components)
-                // * ccw contours which do enclose this contour but are not the
-                //   closest match
-
-                // sort the hits so hits in the same contour are adjacent
-                std::sort (info.begin (), info.end (), intersect_info_t::by_contour_id);
-                intersect_buffer_t::iterator it = info.begin ();
-                intersect_info_t *found_ = 0;
-                while (it != info.end ()) {
-                    int this_contour;
-
-                    intersect_buffer_t::iterator it_up =
-                        std::upper_bound (it+1, info.end (), *it,
-                            intersect_info_t::by_contour_id);
-                    // ignore even contours
-                    int num_hits = it_up - it;
-                    if (even (num_hits))
-                        goto next_intersect;
-                    // ignore cw contours.
-                    // [the contour we're processing is cw too, so self-intersects
-                    //  will be detected here]
-                    this_contour = it->iedge->contour;
-                    if (!ccw[this_contour])
-                        goto next_intersect;
-                    // find closest match in this contour
-                    {
-                        intersect_buffer_t::iterator it_candidate =
-                            std::min_element (it, it_up,
-                                    intersect_info_t::by_normal_coordinate);
-                        if (found_) {
-                            if (found_->inc > it_candidate->inc)
-                                found_ = &*it_candidate;
-                        } else {
-                            found_ = &*it_candidate;
-                        }
-                    }
-                next_intersect:
-                    it = it_up;
-                }
+        if (!by_sweep || !assign_cavities_by_sweep (b, ccw))
+            assign_cavities_by_rays (b, ccw);
+    }
+    return ret;
+}
 
-                if (found_) {
-                    relabel_contour (b, cit, found_->iedge->label);
-                    goto next_contour;
-                }
+namespace {
+    // the dividers along one axis are introduced in increasing order.  the
+    // edges wait in a bucket for the first divider their coordinates
+    // reach, so each divider only looks at the edges which may cross it,
+    // instead of all of them.
+    class DividerBuckets {
+    public:
+        DividerBuckets (const Boundary &b, int axis,
+                        const std::vector <double> &dividers)
+            : my_b (b), my_axis (axis), my_dividers (dividers),
+              my_bucket (dividers.size ())
+        {
+            Boundary::contour_iterator cit;
+            Boundary::edge_iterator eit;
+            for (cit = b.contours_begin (); cit != b.contours_end (); ++cit)
+            for (eit = b.edges_begin (cit); eit != b.edges_end (cit); ++eit)
+                file (eit, -1);
+        }
 
-                // we hit the outer boundary without finding a ccw contour.
-                // most probably, this is a user error.
-                die ("label_by_component: hit dataset boundary while searching for exterior boundary. "
-                     "most probably, your polygons' vertices are in inverse order.");
-            }
-        next_contour:;
+        // take out the edges reaching divider i
+        void take (int i, std::vector <Boundary::edge_iterator> *edges) {
+            edges->clear ();
+            my_bucket[i].swap (*edges);
         }
-    }
-    return ret;
+
+        // put an edge into the bucket of the first divider after
+        // divider i which it reaches, if any
+        void file (Boundary::edge_iterator eit, int i) {
+            const double c0 = my_b.edge_vertex0 (eit)[my_axis];
+            const double c1 = my_b.edge_vertex1 (eit)[my_axis];
+            std::vector <double>::const_iterator it = std::lower_bound (
+                my_dividers.begin () + (i+1), my_dividers.end (),
+                std::min (c0, c1));
+            if (it != my_dividers.end () && *it <= std::max (c0, c1))
+                my_bucket[it - my_dividers.begin ()].push_back (eit);
+        }
+
+    private:
+        const Boundary &my_b;
+        int my_axis;
+        const std::vector <double> &my_dividers;
+        std::vector <std::vector <Boundary::edge_iterator> > my_bucket;
+    };
 }
 
-static void introduce_divider (Boundary *b, const vec_t &line_0, const vec_t &line_dir) {
+// split the edges crossing divider i
+static void introduce_divider (Boundary *b, DividerBuckets *buckets, int i,
+                               const vec_t &line_0, const vec_t &line_dir) {
+    std::vector <Boundary::edge_iterator> edges;
+    buckets->take (i, &edges);
     intersect_buffer_t buff;
-    intersect_line_boundary (&buff, line_0, line_dir, b);
+    intersect_line_edges (&buff, line_0, line_dir, *b, edges);
     intersect_buffer_t::iterator it;
     for (it = buff.begin (); it != buff.end (); ++it) {
         b->split_edge (it->iedge, it->ivtx);
+        Boundary::edge_iterator second_half = it->iedge;
+        buckets->file (++second_half, i);
     }
+    for (size_t k = 0; k != edges.size (); ++k)
+        buckets->file (edges[k], i);
 }
 
 struct EdgePrinter {
@@ -163,12 +409,15 @@ private:
     std::ostream &stream_;
 };
 
-static void introduce_divider_w0 (Boundary *b, const vec_t &line_0, const vec_t &line_dir) {
+static void introduce_divider_w0 (Boundary *b, DividerBuckets *buckets, int i,
+                                  const vec_t &line_0, const vec_t &line_dir) {
     typedef Boundary::edge_iterator edge_iterator;
 
     // compute all the intersections
+    std::vector <edge_iterator> edges;
+    buckets->take (i, &edges);
     intersect_buffer_t buff;
-    intersect_line_boundary (&buff, line_0, line_dir, b);
+    intersect_line_edges (&buff, line_0, line_dir, *b, edges);
     intersect_buffer_t::iterator it;
     if (! even (buff.size ())) {
         std::cerr << "An odd number of intersects was found while dividing the dataset into labels.\n";
@@ -186,17 +435,22 @@ static void introduce_divider_w0 (Boundary *b, const vec_t &line_0, const vec_t
         assert (it->sign == +1);
     }
 
-    // add new edges along the divider
+    // add new edges along the divider.  they do not reach the later
+    // dividers of this direction.
     for (it = buff.begin (); it != buff.end (); ++it) {
         b->split_edge (it->iedge, it->ivtx);
         edge_iterator frst_edge_split = it->iedge;
+        buckets->file (++edge_iterator (frst_edge_split), i);
         edge_iterator sec_edge_split = (++it)->iedge;
         b->split_edge (it->iedge, it->ivtx);
+        buckets->file (++edge_iterator (sec_edge_split), i);
         if (frst_edge_split->contour == sec_edge_split->contour)
             b->split_contour_inserting_edge (frst_edge_split, sec_edge_split);
         else
             b->merge_contours_inserting_edge (frst_edge_split, sec_edge_split);
     }
+    for (size_t k = 0; k != edges.size (); ++k)
+        buckets->file (edges[k], i);
 }
 
 
@@ -207,20 +461,32 @@ int label_by_domain (Boundary *b, const rect_t &bbox, int divx, int divy,
     double xstrip = bbox.right - bbox.left;
     assert (xstrip > 0.);
     xstrip /= divx;
-    for (int i = 0; i <= divx; ++i) {
-        if (for_nu_equals_zero)
-            introduce_divider_w0 (b, vec_t (bbox.left + xstrip*i, 0.), vec_t (0., 1.));
-        else
-            introduce_divider (b, vec_t (bbox.left + xstrip*i, 0.), vec_t (0., 1.));
+    std::vector <double> xdividers (divx + 1);
+    for (int i = 0; i <= divx; ++i)
+        xdividers[i] = bbox.left + xstrip*i;
+    {
+        DividerBuckets buckets (*b, 0, xdividers);
+        for (int i = 0; i <= divx; ++i) {
+            if (for_nu_equals_zero)
+                introduce_divider_w0 (b, &buckets, i, vec_t (xdividers[i], 0.), vec_t (0., 1.));
+            else
+                introduce_divider (b, &buckets, i, vec_t (xdividers[i], 0.), vec_t (0., 1.));
+        }
     }
     double ystrip = bbox.top - bbox.bottom;
     assert (ystrip > 0.);
     ystrip /= divy;
-    for (int i = 0; i <= divy; ++i) {
-        if (for_nu_equals_zero)
-            introduce_divider_w0 (b, vec_t (0., bbox.bottom + ystrip*i), vec_t (1., 0.));
-        else
-            introduce_divider (b, vec_t (0., bbox.bottom + ystrip*i), vec_t (1., 0.));
+    std::vector <double> ydividers (divy + 1);
+    for (int i = 0; i <= divy; ++i)
+        ydividers[i] = bbox.bottom + ystrip*i;
+    {
+        DividerBuckets buckets (*b, 1, ydividers);
+        for (int i = 0; i <= divy; ++i) {
+            if (for_nu_equals_zero)
+                introduce_divider_w0 (b, &buckets, i, vec_t (0., ydividers[i]), vec_t (1., 0.));
+            else
+                introduce_divider (b, &buckets, i, vec_t (0., ydividers[i]), vec_t (1., 0.));
+        }
     }
 
     // the subdividing process generates a lot of small edges in some cases.
@@ -0,0 +1,343 @@
+// vim: et:sw=4:ts=4
+// libpapaya, the minkowski functionals of images and polygons in memory,
+// and the points of reference shared with the papaya program.
+
+#include "libpapaya_internal.h"
+#include <stdexcept>
+#include <math.h>
+
+void set_refvert_com (func_iterator begin, func_iterator end,
+                      const Boundary &b, int num_labels) {
+    if (begin == end)
+        return;
+    VectorMinkowskiFunctional *w010 = create_w010 ();
+    ScalarMinkowskiFunctional *w000 = create_w000 ();
+    w010->global_ref_vertex (vec_t (0., 0.));
+    FusedMinkowskiFunctionals f;
+    f.w010 = w010;
+    f.w000 = w000;
+    f.add_boundary (b);
+    for (; begin != end; ++begin) {
+        for (int l = 0; l != num_labels; ++l) {
+            vec_t refvert = w010->value (l) / w000->value (l);
+            (*begin)->ref_vertex (l, refvert);
+        }
+    }
+    delete w010;
+    delete w000;
+}
+
+void set_refvert_cos (func_iterator begin, func_iterator end,
+                      const Boundary &b, int num_labels) {
+    if (begin == end)
+        return;
+    VectorMinkowskiFunctional *w110 = create_w110 ();
+    ScalarMinkowskiFunctional *w100 = create_w100 ();
+    w110->global_ref_vertex (vec_t (0., 0.));
+    FusedMinkowskiFunctionals f;
+    f.w110 = w110;
+    f.w100 = w100;
+    f.add_boundary (b);
+    for (; begin != end; ++begin) {
+        for (int l = 0; l != num_labels; ++l) {
+            vec_t refvert = w110->value (l) / w100->value (l);
+            (*begin)->ref_vertex (l, refvert);
+        }
+    }
+    delete w110;
+    delete w100;
+}
+
+void set_refvert_coc (func_iterator begin, func_iterator end,
+                      const Boundary &b, int num_labels) {
+    if (begin == end)
+        return;
+    VectorMinkowskiFunctional *w210 = create_w210 ();
+    ScalarMinkowskiFunctional *w200 = create_w200 ();
+    w210->global_ref_vertex (vec_t (0., 0.));
+    FusedMinkowskiFunctionals f;
+    f.w210 = w210;
+    f.w200 = w200;
+    f.add_boundary (b);
+    bool vanishing = false;
+    for (int l = 0; l != num_labels; ++l)
+        vanishing |= fabs (w200->value (l) / W2_NORMALIZATION) < .95*M_PI;
+    for (; begin != end && !vanishing; ++begin) {
+        for (int l = 0; l != num_labels; ++l) {
+            vec_t refvert = w210->value (l) / w200->value (l);
+            (*begin)->ref_vertex (l, refvert);
+        }
+    }
+    delete w210;
+    delete w200;
+    // die () may throw, so only after cleaning up
+    if (vanishing)
+        die ("error: some labels have vanishing total curvature.\n"
+             "the _coc reference vertex does not exist in this case.\n"
+             "you probably want to use point_of_reference = contour_com or component_com instead.");
+}
+
+void set_refvert_origin (func_iterator begin, func_iterator end,
+                         int num_labels) {
+    vec_t refvert = vec_t (0., 0.);
+    for (; begin != end; ++begin) {
+        for (int l = 0; l != num_labels; ++l) {
+            (*begin)->ref_vertex (l, refvert);
+        }
+    }
+}
+
+void set_refvert_domain_center (func_iterator begin, func_iterator end,
+                                const rect_t &r,
+                                int xdomains, int ydomains) {
+    for (; begin != end; ++begin) {
+        for (int l = 0; l != xdomains*ydomains; ++l) {
+            (*begin)->ref_vertex (l, label_domain_center (
+                l, r, xdomains, ydomains));
+        }
+    }
+}
+
+papaya_options_t::papaya_options_t ()
+    : threshold (.9), invert (false), connectblack (false),
+      periodic_data (false), interpolate (false),
+      fix_contours (true), force_counterclockwise (true),
+      labels ("by_component"), point_of_reference ("origin"),
+      clip_left (0.), clip_right (0.), clip_top (0.), clip_bottom (0.),
+      xdomains (1), ydomains (1), num_threads (1) { }
+
+static void option_error (const std::string &msg) {
+    throw std::runtime_error ("papaya: " + msg);
+}
+
+// all the functionals, deleted along with it
+class AllFunctionals : public FusedMinkowskiFunctionals {
+public:
+    AllFunctionals () {
+        w000 = create_w000 ();
+        w100 = create_w100 ();
+        w200 = create_w200 ();
+        w010 = create_w010 ();
+        w110 = create_w110 ();
+        w210 = create_w210 ();
+        w020 = create_w020 ();
+        w120 = create_w120 ();
+        w102 = create_w102 ();
+        w220 = create_w220 ();
+        w211 = create_w211 ();
+    }
+    ~AllFunctionals () {
+        delete w000;
+        delete w100;
+        delete w200;
+        delete w010;
+        delete w110;
+        delete w210;
+        delete w020;
+        delete w120;
+        delete w102;
+        delete w220;
+        delete w211;
+    }
+
+private:
+    AllFunctionals (const AllFunctionals &);
+    AllFunctionals &operator= (const AllFunctionals &);
+};
+
+static void copy_values (std::vector <double> *dst,
+                         const ScalarMinkowskiFunctional *f, int num_labels) {
+    dst->resize (num_labels);
+    for (int l = 0; l != num_labels; ++l)
+        (*dst)[l] = f->value (l);
+}
+
+static void copy_values (std::vector <double> *dst,
+                         const VectorMinkowskiFunctional *f, int num_labels) {
+    dst->resize (2*num_labels);
+    for (int l = 0; l != num_labels; ++l)
+    for (int i = 0; i != 2; ++i)
+        (*dst)[2*l + i] = f->value (l)[i];
+}
+
+static void copy_values (std::vector <double> *dst,
+                         const MatrixMinkowskiFunctional *f, int num_labels) {
+    dst->resize (4*num_labels);
+    for (int l = 0; l != num_labels; ++l)
+    for (int i = 0; i != 2; ++i)
+    for (int j = 0; j != 2; ++j)
+        (*dst)[4*l + 2*i + j] = f->value (l)(i,j);
+}
+
+void papaya_evaluate_boundary (papaya_results_t *res, Boundary *b,
+                               const papaya_options_t &opt) {
+    // the library must not abort the program which calls it
+    DieThrows die_throws;
+    const std::string &labels = opt.labels;
+    const std::string &point_of_ref = opt.point_of_reference;
+    if (opt.num_threads < 1)
+        option_error ("invalid number of threads");
+    assert_sensible_boundary (*b);
+    b->cache_geometry ();
+
+    AllFunctionals funcs;
+    funcs.num_threads = opt.num_threads;
+    AbstractMinkowskiFunctional *all_funcs[]
+        = { funcs.w020, funcs.w120, funcs.w220,
+            funcs.w010, funcs.w110, funcs.w210 };
+    func_iterator all_funcs_begin = all_funcs;
+    func_iterator all_funcs_end   = all_funcs
+                                    + sizeof (all_funcs)/sizeof (*all_funcs);
+
+    // W000, W010 and W020 are taken from a separate boundary in by_domain
+    // mode, like in the papaya program
+    Boundary b_for_w0_storage_;
+    Boundary *b_for_w0 = b;
+    int num_labels;
+    if (labels == "none") {
+        if (point_of_ref != "origin")
+            option_error ("labels = none needs point_of_reference = origin");
+        num_labels = label_none (b);
+        set_refvert_origin (all_funcs_begin, all_funcs_end, num_labels);
+    } else if (labels == "by_contour" || labels == "by_component") {
+        const std::string kind = labels == "by_contour" ? "contour_"
+                                                         : "component_";
+        num_labels = labels == "by_contour" ? label_by_contour_index (b)
+                                            : label_by_component (b);
+        if (point_of_ref == kind + "com")
+            set_refvert_com (all_funcs_begin, all_funcs_end, *b, num_labels);
+        else if (point_of_ref == kind + "cos")
+            set_refvert_cos (all_funcs_begin, all_funcs_end, *b, num_labels);
+        else if (point_of_ref == kind + "coc")
+            set_refvert_coc (all_funcs_begin, all_funcs_end, *b, num_labels);
+        else if (point_of_ref == "origin")
+            set_refvert_origin (all_funcs_begin, all_funcs_end, num_labels);
+        else
+            option_error ("invalid point_of_reference \"" + point_of_ref + "\"");
+    } else if (labels == "by_domain") {
+        rect_t clip;
+        clip.left   = opt.clip_left;
+        clip.right  = opt.clip_right;
+        clip.top    = opt.clip_top;
+        clip.bottom = opt.clip_bottom;
+        if (opt.xdomains <= 0 || opt.ydomains <= 0)
+            option_error ("invalid number of domains");
+        if (point_of_ref != "origin" && point_of_ref != "domain_center")
+            option_error ("invalid point_of_reference \"" + point_of_ref + "\"");
+        b_for_w0_storage_ = *b;
+        b_for_w0 = &b_for_w0_storage_;
+        label_by_domain (b_for_w0, clip, opt.xdomains, opt.ydomains, true);
+        num_labels = label_by_domain (b, clip, opt.xdomains, opt.ydomains,
+                                      false);
+        if (point_of_ref == "origin")
+            set_refvert_origin (all_funcs_begin, all_funcs_end, num_labels);
+        else
+            set_refvert_domain_center (all_funcs_begin, all_funcs_end,
+                                       clip, opt.xdomains, opt.ydomains);
+    } else {
+        option_error ("invalid labels \"" + labels + "\"");
+    }
+
+    FusedMinkowskiFunctionals f = funcs;
+    if (b_for_w0 != b) {
+        FusedMinkowskiFunctionals f_w0;
+        f_w0.w000 = funcs.w000;
+        f_w0.w010 = funcs.w010;
+        f_w0.w020 = funcs.w020;
+        f_w0.num_threads = opt.num_threads;
+        f_w0.add_boundary (FrozenBoundary (*b_for_w0));
+        f.w000 = 0;
+        f.w010 = 0;
+        f.w020 = 0;
+    }
+    f.add_boundary (FrozenBoundary (*b));
+
+    res->num_labels = num_labels;
+    copy_values (&res->w000, funcs.w000, num_labels);
+    copy_values (&res->w100, funcs.w100, num_labels);
+    copy_values (&res->w200, funcs.w200, num_labels);
+    copy_values (&res->w010, funcs.w010, num_labels);
+    copy_values (&res->w110, funcs.w110, num_labels);
+    copy_values (&res->w210, funcs.w210, num_labels);
+    copy_values (&res->w020, funcs.w020, num_labels);
+    copy_values (&res->w120, funcs.w120, num_labels);
+    copy_values (&res->w102, funcs.w102, num_labels);
+    copy_values (&res->w220, funcs.w220, num_labels);
+    copy_values (&res->w211, funcs.w211, num_labels);
+    res->ref_vertex.resize (2*num_labels);
+    for (int l = 0; l != num_labels; ++l)
+    for (int i = 0; i != 2; ++i)
+        res->ref_vertex[2*l + i] = funcs.w020->ref_vertex (l)[i];
+}
+
+// the image is already inverted if that is asked for
+static void evaluate_pixmap (papaya_results_t *res, const Pixmap &image,
+                             const papaya_options_t &opt) {
+    DieThrows die_throws;
+    if (opt.num_threads < 1)
+        option_error ("invalid number of threads");
+    Boundary b;
+    marching_squares (&b, image, opt.threshold, opt.connectblack,
+                      opt.periodic_data, opt.num_threads, opt.interpolate);
+    papaya_evaluate_boundary (res, &b, opt);
+}
+
+void papaya_evaluate_image (papaya_results_t *res, const double *pixels,
+                            int width, int height,
+                            const papaya_options_t &opt) {
+    DieThrows die_throws;
+    if (width <= 0 || height <= 0)
+        option_error ("invalid image size");
+    Pixmap image;
+    image.resize (width, height);
+    for (int y = 0; y != height; ++y)
+    for (int x = 0; x != width; ++x)
+        image (x, y) = Pixmap::val_t (pixels[long (y)*width + x]);
+    if (opt.invert)
+        invert (&image);
+    evaluate_pixmap (res, image, opt);
+}
+
+void papaya_evaluate_image (papaya_results_t *res, const Pixmap &image,
+                            const papaya_options_t &opt) {
+    if (!opt.invert) {
+        evaluate_pixmap (res, image, opt);
+        return;
+    }
+    Pixmap inverted = image;
+    invert (&inverted);
+    evaluate_pixmap (res, inverted, opt);
+}
+
+void papaya_evaluate_polygons (papaya_results_t *res, int num_contours,
+                               const int *contour_begin,
+                               const double *x, const double *y,
+                               const papaya_options_t &opt) {
+    DieThrows die_throws;
+    if (num_contours < 0 || (num_contours && contour_begin[0] != 0))
+        option_error ("invalid contour offsets");
+    Boundary b;
+    for (int c = 0; c != num_contours; ++c) {
+        const int begin = contour_begin[c], end = contour_begin[c+1];
+        if (end < begin + 2)
+            option_error ("invalid contour offsets");
+        int initial_vertex = b.insert_vertex (x[begin], y[begin]);
+        int initial_edge = Boundary::INVALID_EDGE;
+        int prev_vertex = initial_vertex, prev_edge = Boundary::INVALID_EDGE;
+        for (int i = begin + 1; i != end; ++i) {
+            int vertex = b.insert_vertex (x[i], y[i]);
+            prev_edge = b.insert_edge (prev_edge, prev_vertex, vertex,
+                                       Boundary::INVALID_EDGE);
+            if (initial_edge == Boundary::INVALID_EDGE)
+                initial_edge = prev_edge;
+            prev_vertex = vertex;
+        }
+        // close contour
+        b.insert_edge (prev_edge, prev_vertex, initial_vertex, initial_edge);
+    }
+    if (opt.fix_contours)
+        fix_contours (&b, true);
+    if (opt.force_counterclockwise)
+        force_counterclockwise_contours (&b);
+    papaya_evaluate_boundary (res, &b, opt);
+}
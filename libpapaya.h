@@ -0,0 +1,67 @@
+// vim: et:sw=4:ts=4
+// libpapaya, the minkowski functionals of images and polygons in memory.
+// programs which produce their shapes themselves (e.g. every step of a
+// simulation) can evaluate them in-process instead of writing PGM files
+// for the papaya program.  the library is built as libpapaya.a and
+// libpapaya.so, and contains everything but the command line driver.
+// this header only needs the standard library.
+#ifndef LIBPAPAYA_H_INCLUDED
+#define LIBPAPAYA_H_INCLUDED
+
+#include <string>
+#include <vector>
+
+// the settings of the configuration file which decide about the values
+// of the functionals.  the defaults are those of papaya.conf, except for
+// the labels, which are by_component about the origin.
+struct papaya_options_t {
+    papaya_options_t ();
+
+    // the segmentation of images, as in [segment]
+    double threshold;
+    bool invert, connectblack, periodic_data, interpolate;
+    // polygons, as in [polyinput].  the contours are fixed silently.
+    bool fix_contours, force_counterclockwise;
+    // as in [output]: labels is none, by_contour, by_component or
+    // by_domain, and point_of_reference one of the values allowed there
+    // for these labels
+    std::string labels, point_of_reference;
+    // the clipping rectangle and the number of domains for by_domain, as
+    // in [domains]
+    double clip_left, clip_right, clip_top, clip_bottom;
+    int xdomains, ydomains;
+    int num_threads;
+};
+
+// the functionals of every label in plain arrays.  the scalars have one
+// value per label, the vectors two (x, y), and the tensors four (xx, xy,
+// yx, yy); e.g. w020[4*l + 1] is the xy component of W020 of label l.
+// ref_vertex holds the point of reference of each label, like a vector.
+struct papaya_results_t {
+    int num_labels;
+    std::vector <double> w000, w100, w200;
+    std::vector <double> w010, w110, w210;
+    std::vector <double> w020, w120, w102, w220, w211;
+    std::vector <double> ref_vertex;
+};
+
+// the functionals of an image of width x height pixels with values in
+// 0...1, stored row by row starting at the top, like in PGM files.
+void papaya_evaluate_image (papaya_results_t *, const double *pixels,
+                            int width, int height, const papaya_options_t &);
+// the functionals of closed polygons.  the vertices of contour c are
+// (x[i], y[i]) for i in [contour_begin[c], contour_begin[c+1]), so
+// contour_begin has num_contours + 1 entries, like the offsets of a
+// .bpoly file.
+void papaya_evaluate_polygons (papaya_results_t *, int num_contours,
+                               const int *contour_begin,
+                               const double *x, const double *y,
+                               const papaya_options_t &);
+
+// invalid options and input, and anything else papaya cannot evaluate
+// (e.g. a vanishing total curvature with the *_coc points of reference,
+// or contours which do not nest properly), raise std::runtime_error.
+// the calls are independent of each other, and may be made from several
+// threads at once.
+
+#endif // LIBPAPAYA_H_INCLUDED
@@ -0,0 +1,35 @@
+// vim: et:sw=4:ts=4
+// the parts of libpapaya which work on papaya's own types, for the papaya
+// program and the tests.
+#ifndef LIBPAPAYA_INTERNAL_H_INCLUDED
+#define LIBPAPAYA_INTERNAL_H_INCLUDED
+
+#include "util.h"
+#include "minkval.h"
+#include "libpapaya.h"
+
+// papaya_evaluate_image for a Pixmap
+void papaya_evaluate_image (papaya_results_t *, const Pixmap &,
+                            const papaya_options_t &);
+// the same as papaya_evaluate_polygons for a Boundary, which is labelled
+// in place
+void papaya_evaluate_boundary (papaya_results_t *, Boundary *,
+                               const papaya_options_t &);
+
+// setting the points of reference of labels [0, num_labels) of all the
+// functionals in [begin, end): the centers of mass (W010/W000), of
+// surface (W110/W100) or of curvature (W210/W200) of the labels, the
+// origin, or the centers of the domains.
+typedef AbstractMinkowskiFunctional **func_iterator;
+void set_refvert_com (func_iterator begin, func_iterator end,
+                      const Boundary &, int num_labels);
+void set_refvert_cos (func_iterator begin, func_iterator end,
+                      const Boundary &, int num_labels);
+void set_refvert_coc (func_iterator begin, func_iterator end,
+                      const Boundary &, int num_labels);
+void set_refvert_origin (func_iterator begin, func_iterator end,
+                         int num_labels);
+void set_refvert_domain_center (func_iterator begin, func_iterator end,
+                                const rect_t &, int xdomains, int ydomains);
+
+#endif // LIBPAPAYA_INTERNAL_H_INCLUDED
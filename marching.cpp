@@ -5,17 +5,56 @@
 
 #include "util.h"
 #include <stdarg.h>
+#include <limits.h>
+#include <pthread.h>
+#include <list>
+#include <deque>
+#include <stdexcept>
 #define MARCSQ_NO_LOG
 
 namespace {
 
+// one bit per site of the dual lattice.  each row starts on a new word,
+// so that threads working on different rows never share a word.
+class VisitedSet {
+public:
+    void resize (int dimx, int dimy);
+    bool operator() (int x, int y) const;
+    void set (int x, int y);
+
+private:
+    typedef unsigned long word_t;
+    enum { WORD_BITS = sizeof (word_t) * CHAR_BIT };
+    int my_stride;
+    std::vector <word_t> my_bits;
+};
+
+inline void VisitedSet::resize (int dimx, int dimy) {
+    my_stride = (dimx + WORD_BITS - 1) / WORD_BITS;
+    my_bits.assign (size_t (my_stride) * dimy, 0ul);
+}
+
+inline bool VisitedSet::operator() (int x, int y) const {
+    return (my_bits[size_t (y) * my_stride + x / WORD_BITS]
+            >> (x % WORD_BITS)) & 1ul;
+}
+
+inline void VisitedSet::set (int x, int y) {
+    my_bits[size_t (y) * my_stride + x / WORD_BITS] |= 1ul << (x % WORD_BITS);
+}
+
 class MarchingSquares {
     // just a dummy class to hold the algorithm's state
 public:
-    MarchingSquares (bool connect_body, bool periodic_data);
+    MarchingSquares (bool connect_body, bool periodic_data,
+                     bool interpolate = false);
 
     void run (Boundary *, const Pixmap &dataset,
-              Pixmap::val_t threshold);
+              Pixmap::val_t threshold, int num_threads);
+    int run_streaming (FrozenBoundarySink *, PixmapRowSource *,
+                       Pixmap::val_t threshold, bool by_component);
+    void run_level_set_sweep (std::vector <level_set_t> *, const Pixmap &,
+                              const std::vector <double> &thresholds);
 
 private:
     enum {
@@ -27,82 +66,147 @@ private:
 
     typedef Pixmap::val_t val_t;
 
+    // a piece of a contour within a band of rows [y0, y1) of the dual
+    // lattice.  it enters the band through the seam at the top of band
+    // entry_seam, at column entry_x, and leaves through exit_seam, exit_x.
+    // closed contours which lie completely inside the band have
+    // entry_seam = exit_seam = -1.
+    struct chain_t {
+        int entry_seam, entry_x;
+        int exit_seam, exit_x;
+        // vertex coordinates, x and y interleaved.  vertex i is placed
+        // when leaving the i-th site of the chain.
+        std::vector <double> vert;
+        // the first non-ambiguous site in scan order, and the vertex placed
+        // when leaving it.  the serial code starts the contour there.
+        long min_site;
+        int min_vert;
+    };
+
+    struct band_t {
+        MarchingSquares *self;
+        int index;
+        int y0, y1;
+        std::vector <chain_t> chains;
+        // whether die () throws in the thread which started the band,
+        // and the message if it did in this band
+        bool die_throws;
+        std::string error;
+    };
+
+    // an open contour in the streaming variant.  it starts where it comes
+    // up through the seam tail_seam (at column tail_x) and ends where it
+    // goes down through head_seam.  the vertices are kept in chunks, so
+    // that contours can be joined without copying.
+    struct fragment_t {
+        std::list <std::vector <double> > vert;
+        int tail_seam, tail_x;
+        int head_seam, head_x;
+        // when labelling by component: the piece it was started as, and
+        // its first non-ambiguous site in scan order so far.
+        int piece;
+        long first_site;
+    };
+
+    // the contour pieces seen by the streaming variant, joined into the
+    // components they bound.  a union-find structure; the root of each
+    // component knows the first site of its outer contour, once that
+    // has been closed.  the contours get running labels, one per root
+    // when its first contour is closed, so that there are not many more
+    // labels than components (and not one per piece).  label_piece[l]
+    // is the piece which got label l.
+    struct components_t {
+        std::vector <int> parent;
+        std::vector <long> outer_site;
+        std::vector <int> label, label_piece;
+        int add ();
+        int find (int piece);
+        void join (int a, int b);
+        int label_of (int piece);
+    };
+
     Boundary *boundary;
-    Pixmap dataset;
+    // the image is not copied.  instead, the padded coordinates are
+    // mapped to image coordinates by xmap and ymap; -1 means outside
+    // the image (which is black).
+    const Pixmap *dataset;
+    std::vector <int> xmap, ymap;
+    // in the streaming variant, dataset is NULL and padded row y is
+    // found in rows[y%2].
+    std::vector <val_t> rows[2];
     val_t threshold;
+    // images with integer storage are segmented by comparing the raw
+    // values against the threshold on their own scale
+    bool raw_dataset;
+    long raw_threshold;
     const bool connect_void;
     const bool periodic_data;
+    // place the vertices by linear interpolation between the pixel
+    // values, instead of at the midpoints of the pixel edges
+    const bool interpolate;
     const int padding_shift;
-    Pixmap visited;
+    VisitedSet visited;
     int dualxmax;
     int dualymax;
     int square_type (int x, int y);
+    int step (int thisx, int thisy, int prevx, int prevy,
+              int *nextx, int *nexty, double *vertx, double *verty);
+    double crossing (val_t black, val_t white) const;
+    static bool is_ambiguous (int type);
+    static bool is_start_site (int type);
+    double vertex_x (double dualx) const;
+    double vertex_y (double dualy) const;
+    void pad_dataset (const Pixmap &);
+    static void make_padding_map (std::vector <int> *, int size,
+                                  int padding_shift, bool periodic);
+    val_t pixel (int x, int y) const;
+    bool is_white (int x, int y) const;
     void trace_contour (int x, int y);
+    void run_tiled (int num_bands);
+    static void *band_thread (void *);
+    void trace_band (band_t *);
+    void trace_chain (band_t *, chain_t *,
+                      int x, int y, int prevx, int prevy);
+    void stitch_chains (std::vector <band_t> &);
+    void load_row (PixmapRowSource *, int y, std::vector <val_t> *buffer);
+    int trace_row_chain (int x, int y, int prevx, int prevy,
+                         std::vector <double> *vert, int *exit_x,
+                         int *min_x);
+    static bool is_counterclockwise (const fragment_t &);
+    // what a square of each type adds to the level_set_t, in units of
+    // 1/8 pixel area, edges parallel to the axes, diagonal edges and
+    // quarter turns
+    struct square_measures_t {
+        int area, straight, diagonal, turns;
+    };
+    square_measures_t square_measures (int type) const;
     void log (const char *fmt, ...);
-    val_t lowerright (int x, int y);
-    val_t upperright (int x, int y);
-    val_t lowerleft  (int x, int y);
-    val_t upperleft  (int x, int y);
 };
 
-MarchingSquares::MarchingSquares (bool connect_void_, bool periodic_data_)
+MarchingSquares::MarchingSquares (bool connect_void_, bool periodic_data_,
+                                  bool interpolate_)
     : connect_void (connect_void_), periodic_data (periodic_data_),
-      padding_shift (periodic_data_ ? 2 : 1)  {
+      interpolate (interpolate_), padding_shift (periodic_data_ ? 2 : 1)  {
 }
 
 void MarchingSquares::run (Boundary *b, const Pixmap &dataset_,
-                           Pixmap::val_t threshold_) {
+                           Pixmap::val_t threshold_, int num_threads) {
     assert (b);
     boundary = b;
     threshold = threshold_;
     assert (threshold <= Pixmap::max_val ());
     assert (threshold >= Pixmap::min_val ());
-    // create a copy of dataset, padded by a one pixel border
-    // so that contours definitely end there
     log ("init\n");
-    dataset.resize (dataset_.size1 () + 2*padding_shift,
-                    dataset_.size2 () + 2*padding_shift);
-    for (int j = 0; j != dataset.size2 (); ++j)
-    for (int i = 0; i != dataset.size1 (); ++i)
-        dataset(i,j) = Pixmap::min_val ();
-    for (int j = 0; j != dataset_.size2 (); ++j)
-    for (int i = 0; i != dataset_.size1 (); ++i)
-        dataset(i+padding_shift,j+padding_shift) = dataset_(i,j);
-    if (periodic_data) {
-        // copy periodic wrappings in (incredibly messy)
-        const int frow = dataset_.size2 () - 1;
-        assert (frow+3 == dataset.size2 () - 2);
-        for (int i = 0; i != dataset_.size1 (); ++i) {
-            dataset(i+padding_shift,1)      = dataset_(i,frow);
-            dataset(i+padding_shift,frow+3) = dataset_(i,0);
-        }
-        const int fcol = dataset_.size1 () - 1;
-        assert (fcol+3 == dataset.size1 () - 2);
-        for (int j = 0; j != dataset_.size2 (); ++j) {
-            dataset(1,j+padding_shift)      = dataset_(fcol,j);
-            dataset(fcol+3,j+padding_shift) = dataset_(0,j);
-        }
-        dataset(1,1)           = dataset_(fcol,frow);
-        dataset(1,frow+3)      = dataset_(fcol,0);
-        dataset(fcol+3,frow+3) = dataset_(0,0);
-        dataset(fcol+3,1)      = dataset_(0,frow);
-        for (int i = 0; i != dataset.size1 (); ++i) {
-            assert (dataset(i,0) == Pixmap::min_val ());
-            assert (dataset(i,dataset.size2 () - 1) == Pixmap::min_val ());
-        }
-        for (int j = 0; j != dataset_.size2 (); ++j) {
-            assert (dataset(0,j) == Pixmap::min_val ());
-            assert (dataset(dataset.size1 () - 1,j) == Pixmap::min_val ());
-        }
-    }
+    pad_dataset (dataset_);
     // dual lattice sites are centered between pixel centers
-    dualxmax = dataset.size1 () - 1;
-    dualymax = dataset.size2 () - 1;
+    dualxmax = xmap.size () - 1;
+    dualymax = ymap.size () - 1;
     // 1 = site has been visited, 0 = not
     visited.resize (dualxmax, dualymax);
-    for (int j = 0; j != visited.size2 (); ++j)
-    for (int i = 0; i != visited.size1 (); ++i)
-        visited(i,j) = 0;
+    if (num_threads > 1) {
+        run_tiled (std::min (num_threads, dualymax));
+        return;
+    }
     // go through the data and look for a boundary that has not yet been
     // treated
     log ("traces\n");
@@ -110,21 +214,44 @@ void MarchingSquares::run (Boundary *b, const Pixmap &dataset_,
     for (int xs = 0; xs != dualxmax; ++xs) {
         if (visited(xs,ys))
             continue;
-        int type = square_type (xs, ys);
-        switch (type) {
-        // interior sites
-        case 0:
-        case UPPERLEFT|UPPERRIGHT|LOWERLEFT|LOWERRIGHT:
-            continue;
-        // never start on ambiguous sites.
-        case UPPERLEFT|LOWERRIGHT:
-        case UPPERRIGHT|LOWERLEFT:
-            continue;
-        }
-        trace_contour (xs, ys);
+        if (is_start_site (square_type (xs, ys)))
+            trace_contour (xs, ys);
+    }
+}
+
+void MarchingSquares::pad_dataset (const Pixmap &dataset_) {
+    // pad the dataset by a one pixel border so that contours definitely
+    // end there.  periodic data additionally get a copy of the opposite
+    // row or column in front of the border, i.e. padded coordinate 1
+    // maps to the last row or column of the image.
+    dataset = &dataset_;
+    raw_dataset = dataset_.storage () != Pixmap::FLOAT;
+    if (raw_dataset)
+        raw_threshold = dataset_.raw_threshold (threshold);
+    make_padding_map (&xmap, dataset_.size1 (), padding_shift, periodic_data);
+    make_padding_map (&ymap, dataset_.size2 (), padding_shift, periodic_data);
+}
+
+void MarchingSquares::make_padding_map (std::vector <int> *map, int size,
+                                        int padding_shift, bool periodic) {
+    map->assign (size + 2*padding_shift, -1);
+    for (int i = 0; i != size; ++i)
+        (*map)[i+padding_shift] = i;
+    if (periodic) {
+        (*map)[1] = size - 1;
+        (*map)[size + 2] = 0;
     }
 }
 
+inline MarchingSquares::val_t MarchingSquares::pixel (int x, int y) const {
+    if (!dataset)
+        return rows[y%2][x];
+    const int i = xmap[x], j = ymap[y];
+    if (i < 0 || j < 0)
+        return Pixmap::min_val ();
+    return (*dataset)(i, j);
+}
+
 void MarchingSquares::trace_contour (int thisx, int thisy) {
     log ("trace_contour (%i, %i)\n", thisx, thisy);
     int prevx = -1;
@@ -133,106 +260,16 @@ void MarchingSquares::trace_contour (int thisx, int thisy) {
     int prevedge = Boundary::INVALID_EDGE;
     int initialedge = Boundary::INVALID_EDGE;
     while (!visited(thisx,thisy)) {
-#define movedown  void ((++nexty, vertx = thisx+.5, verty = thisy+1.))
-#define moveup    void ((--nexty, vertx = thisx+.5, verty = thisy))
-#define moveright void ((++nextx, verty = thisy+.5, vertx = thisx+1.))
-#define moveleft  void ((--nextx, verty = thisy+.5, vertx = thisx))
-        int type = square_type (thisx, thisy);
-        visited(thisx,thisy) = 1;
-        int nextx = thisx;
-        int nexty = thisy;
+        int nextx, nexty;
         double vertx, verty;
-        // find out where to go, and where to put the next vertex.
-        switch (type) {
-        // straightforward cases
-        case UPPERLEFT:
-            moveup;
-            break;
-        case UPPERRIGHT:
-            moveright;
-            break;
-        case LOWERLEFT:
-            moveleft;
-            break;
-        case LOWERRIGHT:
-            movedown;
-            break;
-        case UPPERLEFT|UPPERRIGHT:
-            moveright;
-            break;
-        case LOWERLEFT|LOWERRIGHT:
-            moveleft;
-            break;
-        case LOWERLEFT|UPPERLEFT:
-            moveup;
-            break;
-        case LOWERRIGHT|UPPERRIGHT:
-            movedown;
-            break;
-        case UPPERLEFT|LOWERLEFT|LOWERRIGHT:
-            moveup;
-            break;
-        case UPPERRIGHT|LOWERLEFT|LOWERRIGHT:
-            moveleft;
-            break;
-        case UPPERLEFT|UPPERRIGHT|LOWERLEFT:
-            moveright;
-            break;
-        case UPPERLEFT|UPPERRIGHT|LOWERRIGHT:
-            movedown;
-            break;
-        // ambiguous ones
-        // these are never start sites, so prevx, prevy have sensible values.
-        case UPPERLEFT|LOWERRIGHT:
-            // ambiguous squares are traversed twice
-            visited(thisx,thisy) = 0;
-            if (connect_void) {
-                if (prevx < thisx) {
-                    moveup;
-                } else if (prevx > thisx) {
-                    movedown;
-                } else {
-                    die ("Entered UPPERLEFT|LOWERRIGHT from above or below.\n");
-                }
-            } else {
-                if (prevx < thisx) {
-                    movedown;
-                } else if (prevx > thisx) {
-                    moveup;
-                } else {
-                    die ("Entered UPPERLEFT|LOWERRIGHT from above or below.\n");
-                }
-            }
-            break;
-        case UPPERRIGHT|LOWERLEFT:
-            // ambiguous squares are traversed twice
-            visited(thisx,thisy) = 0;
-            if (connect_void) {
-                if (prevy > thisy) {
-                    moveleft;
-                } else if (prevy < thisy) {
-                    moveright;
-                } else {
-                    die ("Entered UPPERRIGHT|LOWERLEFT from left or right.\n");
-                }
-            } else {
-                if (prevy > thisy) {
-                    moveright;
-                } else if (prevy < thisy) {
-                    moveleft;
-                } else {
-                    die ("Entered UPPERRIGHT|LOWERLEFT from left or right.\n");
-                }
-            }
-            break;
-        default:
-            die ("Lost contact to contour. This should not have happened (type = %i).", type);
-        }
+        int type = step (thisx, thisy, prevx, prevy,
+                         &nextx, &nexty, &vertx, &verty);
+        // ambiguous squares are traversed twice
+        if (!is_ambiguous (type))
+            visited.set (thisx, thisy);
         // add new vertex
-        // bitmap is top-down, but we need right-handed coordinates later
-        int thisvertex = boundary->insert_vertex (
-            vertx + .5 - padding_shift,
-            dataset.size2() - verty - .5 - padding_shift);
+        int thisvertex = boundary->insert_vertex (vertex_x (vertx),
+                                                  vertex_y (verty));
         // add new edge
         if (prevvertex != Boundary::INVALID_VERTEX) {
             int thisedge = boundary->insert_edge (
@@ -246,10 +283,6 @@ void MarchingSquares::trace_contour (int thisx, int thisy) {
         thisx = nextx;
         thisy = nexty;
         prevvertex = thisvertex;
-#undef moveleft
-#undef moveright
-#undef moveup
-#undef movedown
     }
     // encountered start site of this contour.
     // close contour.
@@ -257,31 +290,860 @@ void MarchingSquares::trace_contour (int thisx, int thisy) {
     boundary->insert_edge (prevedge, prevvertex, Boundary::INVALID_VERTEX, initialedge);
 }
 
-inline int MarchingSquares::square_type (int x, int y) {
-    // determine which kind of boundary we found
-    // in type, all "white" pixels are set
-    int type;
-    type  = (upperleft  (x, y) > threshold) * UPPERLEFT;
-    type |= (upperright (x, y) > threshold) * UPPERRIGHT;
-    type |= (lowerleft  (x, y) > threshold) * LOWERLEFT;
-    type |= (lowerright (x, y) > threshold) * LOWERRIGHT;
+// find out where to go from site (thisx, thisy), and where to put the
+// next vertex (in dual lattice coordinates).
+// (prevx, prevy) is the site we came from; it is needed to resolve the
+// ambiguous sites only.  returns the type of the site.
+int MarchingSquares::step (int thisx, int thisy, int prevx, int prevy,
+                           int *nextx_, int *nexty_,
+                           double *vertx_, double *verty_) {
+    int nextx = thisx;
+    int nexty = thisy;
+    double vertx, verty;
+    int type = square_type (thisx, thisy);
+#define movedown  void ((++nexty, vertx = thisx+.5, verty = thisy+1.))
+#define moveup    void ((--nexty, vertx = thisx+.5, verty = thisy))
+#define moveright void ((++nextx, verty = thisy+.5, vertx = thisx+1.))
+#define moveleft  void ((--nextx, verty = thisy+.5, vertx = thisx))
+    // find out where to go, and where to put the next vertex.
+    switch (type) {
+    // straightforward cases
+    case UPPERLEFT:
+        moveup;
+        break;
+    case UPPERRIGHT:
+        moveright;
+        break;
+    case LOWERLEFT:
+        moveleft;
+        break;
+    case LOWERRIGHT:
+        movedown;
+        break;
+    case UPPERLEFT|UPPERRIGHT:
+        moveright;
+        break;
+    case LOWERLEFT|LOWERRIGHT:
+        moveleft;
+        break;
+    case LOWERLEFT|UPPERLEFT:
+        moveup;
+        break;
+    case LOWERRIGHT|UPPERRIGHT:
+        movedown;
+        break;
+    case UPPERLEFT|LOWERLEFT|LOWERRIGHT:
+        moveup;
+        break;
+    case UPPERRIGHT|LOWERLEFT|LOWERRIGHT:
+        moveleft;
+        break;
+    case UPPERLEFT|UPPERRIGHT|LOWERLEFT:
+        moveright;
+        break;
+    case UPPERLEFT|UPPERRIGHT|LOWERRIGHT:
+        movedown;
+        break;
+    // ambiguous ones
+    // these are never start sites, so prevx, prevy have sensible values.
+    case UPPERLEFT|LOWERRIGHT:
+        if (connect_void) {
+            if (prevx < thisx) {
+                moveup;
+            } else if (prevx > thisx) {
+                movedown;
+            } else {
+                die ("Entered UPPERLEFT|LOWERRIGHT from above or below.\n");
+            }
+        } else {
+            if (prevx < thisx) {
+                movedown;
+            } else if (prevx > thisx) {
+                moveup;
+            } else {
+                die ("Entered UPPERLEFT|LOWERRIGHT from above or below.\n");
+            }
+        }
+        break;
+    case UPPERRIGHT|LOWERLEFT:
+        if (connect_void) {
+            if (prevy > thisy) {
+                moveleft;
+            } else if (prevy < thisy) {
+                moveright;
+            } else {
+                die ("Entered UPPERRIGHT|LOWERLEFT from left or right.\n");
+            }
+        } else {
+            if (prevy > thisy) {
+                moveright;
+            } else if (prevy < thisy) {
+                moveleft;
+            } else {
+                die ("Entered UPPERRIGHT|LOWERLEFT from left or right.\n");
+            }
+        }
+        break;
+    default:
+        die ("Lost contact to contour. This should not have happened (type = %i).", type);
+    }
+#undef moveleft
+#undef moveright
+#undef moveup
+#undef movedown
+    if (interpolate) {
+        // the vertex is on a horizontal pixel edge if verty is whole,
+        // else on a vertical one.
+        if (verty != thisy + .5) {
+            const int y = int (verty);
+            const val_t left = pixel (thisx, y), right = pixel (thisx+1, y);
+            vertx = is_white (thisx, y) ? thisx + 1. - crossing (right, left)
+                                     : thisx + crossing (left, right);
+        } else {
+            const int x = int (vertx);
+            const val_t upper = pixel (x, thisy), lower = pixel (x, thisy+1);
+            verty = is_white (x, thisy) ? thisy + 1. - crossing (lower, upper)
+                                      : thisy + crossing (upper, lower);
+        }
+    }
+    *nextx_ = nextx;
+    *nexty_ = nexty;
+    *vertx_ = vertx;
+    *verty_ = verty;
     return type;
 }
 
-inline MarchingSquares::val_t MarchingSquares::upperleft (int x, int y) {
-    return dataset (x, y);
+// where the threshold is crossed between a black and a white pixel, as
+// the distance from the black one.  kept away from the pixels, so that
+// vertices of neighbouring edges never coincide.
+inline double MarchingSquares::crossing (val_t black, val_t white) const {
+    double t = (double (threshold) - black) / (double (white) - black);
+    return std::min (std::max (t, 1./64), 63./64);
+}
+
+inline bool MarchingSquares::is_ambiguous (int type) {
+    return type == (UPPERLEFT|LOWERRIGHT) || type == (UPPERRIGHT|LOWERLEFT);
+}
+
+inline bool MarchingSquares::is_start_site (int type) {
+    switch (type) {
+    // interior sites
+    case 0:
+    case UPPERLEFT|UPPERRIGHT|LOWERLEFT|LOWERRIGHT:
+        return false;
+    // never start on ambiguous sites.
+    case UPPERLEFT|LOWERRIGHT:
+    case UPPERRIGHT|LOWERLEFT:
+        return false;
+    default:
+        return true;
+    }
 }
 
-inline MarchingSquares::val_t MarchingSquares::upperright (int x, int y) {
-    return dataset (x+1, y);
+// bitmap is top-down, but we need right-handed coordinates later
+inline double MarchingSquares::vertex_x (double dualx) const {
+    return dualx + .5 - padding_shift;
+}
+
+inline double MarchingSquares::vertex_y (double dualy) const {
+    return int (ymap.size ()) - dualy - .5 - padding_shift;
+}
+
+//
+// tiled variant.  the dual lattice is cut into horizontal bands, which
+// are traced by separate threads.  contours which cross the seams between
+// bands are cut into chains, which are joined afterwards.  the contours
+// are then inserted in the same order, and starting at the same vertex,
+// as in the serial code, so the resulting Boundary is identical.
+//
+
+void MarchingSquares::run_tiled (int num_bands) {
+    log ("tiled traces, %i bands\n", num_bands);
+    std::vector <band_t> bands (num_bands);
+    for (int t = 0; t != num_bands; ++t) {
+        bands[t].self = this;
+        bands[t].index = t;
+        bands[t].y0 = int (long (dualymax) * t / num_bands);
+        bands[t].y1 = int (long (dualymax) * (t+1) / num_bands);
+        bands[t].die_throws = die_throws ();
+    }
+    // the calling thread takes the first band.
+    std::vector <pthread_t> threads (num_bands);
+    for (int t = 1; t != num_bands; ++t)
+        if (pthread_create (&threads[t], 0, &band_thread, &bands[t]))
+            die ("marching_squares: unable to create thread");
+    band_thread (&bands[0]);
+    for (int t = 1; t != num_bands; ++t)
+        pthread_join (threads[t], 0);
+    for (int t = 0; t != num_bands; ++t)
+        if (!bands[t].error.empty ())
+            die ("%s", bands[t].error.c_str ());
+    stitch_chains (bands);
 }
 
-inline MarchingSquares::val_t MarchingSquares::lowerleft (int x, int y) {
-    return dataset (x, y+1);
+void *MarchingSquares::band_thread (void *arg) {
+    band_t *band = (band_t *)arg;
+    DieThrows die_throws (band->die_throws);
+    try {
+        band->self->trace_band (band);
+    } catch (std::exception &e) {
+        band->error = e.what ();
+    }
+    return 0;
 }
 
-inline MarchingSquares::val_t MarchingSquares::lowerright (int x, int y) {
-    return dataset (x+1, y+1);
+void MarchingSquares::trace_band (band_t *band) {
+    // the seams are crossed where the two pixels shared by the sites
+    // above and below differ.  white is always on the left hand side
+    // of the contour, which fixes the direction of the crossing.
+    if (band->y0 != 0) {
+        // contours coming down from the band above
+        const int y = band->y0;
+        for (int x = 0; x != dualxmax; ++x) {
+            if (is_white (x,y) || !is_white (x+1,y))
+                continue;
+            band->chains.push_back (chain_t ());
+            chain_t *c = &band->chains.back ();
+            c->entry_seam = band->index;
+            c->entry_x = x;
+            trace_chain (band, c, x, y, x, y-1);
+        }
+    }
+    if (band->y1 != dualymax) {
+        // contours coming up from the band below
+        const int y = band->y1;
+        for (int x = 0; x != dualxmax; ++x) {
+            if (!is_white (x,y) || is_white (x+1,y))
+                continue;
+            band->chains.push_back (chain_t ());
+            chain_t *c = &band->chains.back ();
+            c->entry_seam = band->index + 1;
+            c->entry_x = x;
+            trace_chain (band, c, x, y-1, x, y);
+        }
+    }
+    // what is left are the contours inside the band
+    for (int ys = band->y0; ys != band->y1; ++ys)
+    for (int xs = 0; xs != dualxmax; ++xs) {
+        if (visited(xs,ys))
+            continue;
+        if (!is_start_site (square_type (xs, ys)))
+            continue;
+        band->chains.push_back (chain_t ());
+        chain_t *c = &band->chains.back ();
+        c->entry_seam = -1;
+        c->entry_x = -1;
+        trace_chain (band, c, xs, ys, -1, -1);
+    }
+}
+
+void MarchingSquares::trace_chain (band_t *band, chain_t *c,
+                                   int thisx, int thisy,
+                                   int prevx, int prevy) {
+    c->exit_seam = -1;
+    c->exit_x = -1;
+    c->min_site = LONG_MAX;
+    c->min_vert = -1;
+    while (!visited(thisx,thisy)) {
+        int nextx, nexty;
+        double vertx, verty;
+        int type = step (thisx, thisy, prevx, prevy,
+                         &nextx, &nexty, &vertx, &verty);
+        const long site = long (thisy) * dualxmax + thisx;
+        if (!is_ambiguous (type)) {
+            visited.set (thisx, thisy);
+            if (site < c->min_site) {
+                c->min_site = site;
+                c->min_vert = c->vert.size () / 2;
+            }
+        }
+        c->vert.push_back (vertex_x (vertx));
+        c->vert.push_back (vertex_y (verty));
+        if (nexty < band->y0) {
+            c->exit_seam = band->index;
+            c->exit_x = nextx;
+            return;
+        } else if (nexty >= band->y1) {
+            c->exit_seam = band->index + 1;
+            c->exit_x = nextx;
+            return;
+        }
+        prevx = thisx;
+        prevy = thisy;
+        thisx = nextx;
+        thisy = nexty;
+    }
+    // back at the start site
+    assert (c->entry_seam == -1);
+}
+
+struct contour_order_t {
+    const std::vector <long> *min_site;
+    bool operator() (int a, int b) const {
+        return (*min_site)[a] < (*min_site)[b];
+    }
+};
+
+void MarchingSquares::stitch_chains (std::vector <band_t> &bands) {
+    log ("stitching\n");
+    // number all the chains, and find the chain which starts at each
+    // seam crossing.
+    std::vector <chain_t *> chains;
+    std::vector <int> at_crossing ((bands.size () + 1) * dualxmax, -1);
+    for (int t = 0; t != (int)bands.size (); ++t)
+    for (int i = 0; i != (int)bands[t].chains.size (); ++i) {
+        chain_t *c = &bands[t].chains[i];
+        if (c->entry_seam != -1)
+            at_crossing[c->entry_seam * dualxmax + c->entry_x] = chains.size ();
+        chains.push_back (c);
+    }
+
+    // join the chains to contours.
+    // contour k is made of the chains
+    // contour_chains[contour_begin[k]...contour_begin[k+1]-1]
+    std::vector <int> contour_chains, contour_begin;
+    std::vector <long> min_site;
+    std::vector <int> min_chain, min_vert;
+    std::vector <bool> used (chains.size (), false);
+    for (int first = 0; first != (int)chains.size (); ++first) {
+        if (used[first])
+            continue;
+        contour_begin.push_back (contour_chains.size ());
+        min_site.push_back (LONG_MAX);
+        min_chain.push_back (-1);
+        min_vert.push_back (-1);
+        int cur = first;
+        do {
+            used[cur] = true;
+            const chain_t *c = chains[cur];
+            if (c->min_site < min_site.back ()) {
+                min_site.back () = c->min_site;
+                min_chain.back () = contour_chains.size ();
+                min_vert.back () = c->min_vert;
+            }
+            contour_chains.push_back (cur);
+            if (c->exit_seam == -1)
+                break;
+            cur = at_crossing[c->exit_seam * dualxmax + c->exit_x];
+            if (cur == -1)
+                die ("marching_squares: lost contour at seam %i, x = %i",
+                     c->exit_seam, c->exit_x);
+        } while (cur != first);
+        assert (min_chain.back () != -1);
+    }
+    const int num_contours = contour_begin.size ();
+    contour_begin.push_back (contour_chains.size ());
+
+    // insert the contours in scan order of their start sites
+    std::vector <int> order (num_contours);
+    for (int k = 0; k != num_contours; ++k)
+        order[k] = k;
+    contour_order_t by_start_site;
+    by_start_site.min_site = &min_site;
+    std::sort (order.begin (), order.end (), by_start_site);
+    for (int n = 0; n != num_contours; ++n) {
+        const int k = order[n];
+        int prevvertex = Boundary::INVALID_VERTEX;
+        int prevedge = Boundary::INVALID_EDGE;
+        int initialedge = Boundary::INVALID_EDGE;
+        const int nchains = contour_begin[k+1] - contour_begin[k];
+        int j = min_chain[k] - contour_begin[k];
+        int v = min_vert[k];
+        // go round once, from the start vertex back to the start vertex
+        for (int visited_chains = 0; visited_chains <= nchains; ) {
+            const chain_t *c = chains[contour_chains[contour_begin[k] + j]];
+            int vend = c->vert.size () / 2;
+            if (visited_chains == nchains)
+                vend = min_vert[k];
+            for (; v != vend; ++v) {
+                int thisvertex = boundary->insert_vertex (c->vert[2*v],
+                                                          c->vert[2*v+1]);
+                if (prevvertex != Boundary::INVALID_VERTEX) {
+                    int thisedge = boundary->insert_edge (
+                        prevedge, prevvertex, thisvertex, Boundary::INVALID_EDGE);
+                    if (initialedge == Boundary::INVALID_EDGE)
+                        initialedge = thisedge;
+                    prevedge = thisedge;
+                }
+                prevvertex = thisvertex;
+            }
+            ++visited_chains;
+            j = (j + 1) % nchains;
+            v = 0;
+        }
+        boundary->insert_edge (prevedge, prevvertex, Boundary::INVALID_VERTEX, initialedge);
+    }
+}
+
+//
+// streaming variant.  the dual lattice is processed one row at a time.
+// every contour piece within a row (a "row chain") enters and leaves the
+// row through the seams above and below; it is attached to the open
+// fragments ending at these seams.  a fragment whose head meets its own
+// tail is closed and handed to the sink.
+//
+
+int MarchingSquares::run_streaming (FrozenBoundarySink *sink,
+                                    PixmapRowSource *reader,
+                                    Pixmap::val_t threshold_,
+                                    bool by_component) {
+    assert (sink);
+    threshold = threshold_;
+    assert (threshold <= Pixmap::max_val ());
+    assert (threshold >= Pixmap::min_val ());
+    dataset = 0;
+    raw_dataset = false;
+    make_padding_map (&xmap, reader->size1 (), padding_shift, periodic_data);
+    make_padding_map (&ymap, reader->size2 (), padding_shift, periodic_data);
+    dualxmax = xmap.size () - 1;
+    dualymax = ymap.size () - 1;
+
+    // open fragments, with the fragments whose head / tail is at each
+    // column of the seams above (cur) and below (next) the current row.
+    std::deque <fragment_t> fragments;
+    std::vector <int> free_fragments;
+    std::vector <int> head_at (dualxmax, -1), next_head_at (dualxmax, -1);
+    std::vector <int> tail_at (dualxmax, -1), next_tail_at (dualxmax, -1);
+#define HEAD_AT(seam, x) ((seam) == y ? head_at[x] : next_head_at[x])
+#define TAIL_AT(seam, x) ((seam) == y ? tail_at[x] : next_tail_at[x])
+
+    components_t components;
+    FrozenBoundary batch;
+    const int BATCH_EDGES = 1 << 20;
+    std::vector <double> vert;
+    std::vector <val_t> buffer (reader->size1 ());
+
+    load_row (reader, 0, &buffer);
+    for (int y = 0; y != dualymax; ++y) {
+        load_row (reader, y+1, &buffer);
+        // each crossing of the seams enters the row exactly once:
+        // top down where the left pixel is black, bottom up where the
+        // left pixel is white.
+        for (int from_below = 0; from_below != 2; ++from_below)
+        for (int x = 0; x != dualxmax; ++x) {
+            const int py = y + from_below;
+            const bool left_white = is_white (x, py);
+            const bool right_white = is_white (x+1, py);
+            if (left_white == right_white || left_white != bool (from_below))
+                continue;
+            int exit_x, min_x;
+            vert.clear ();
+            int exit_seam = trace_row_chain (x, y, x, from_below ? y+1 : y-1,
+                                             &vert, &exit_x,
+                                             by_component ? &min_x : 0);
+            const long site = by_component && min_x != INT_MAX
+                            ? long (y) * dualxmax + min_x : LONG_MAX;
+            if (!from_below) {
+                // continue the fragment which comes down from above
+                int f = head_at[x];
+                assert (f != -1);
+                head_at[x] = -1;
+                fragment_t &F = fragments[f];
+                std::vector <double> &last = F.vert.back ();
+                last.insert (last.end (), vert.begin (), vert.end ());
+                F.first_site = std::min (F.first_site, site);
+                if (exit_seam == y+1) {
+                    F.head_seam = y+1;
+                    F.head_x = exit_x;
+                    next_head_at[exit_x] = f;
+                    continue;
+                }
+                int g = tail_at[exit_x];
+                assert (g != -1);
+                tail_at[exit_x] = -1;
+                if (g == f) {
+                    // closed
+                    int label = 0;
+                    if (by_component) {
+                        label = components.label_of (F.piece);
+                        // like label_by_component, take the
+                        // counterclockwise contours as the outer ones
+                        const int root = components.find (F.piece);
+                        if (is_counterclockwise (F))
+                            components.outer_site[root] = std::min (
+                                components.outer_site[root], F.first_site);
+                    }
+                    std::list <std::vector <double> >::const_iterator it;
+                    for (it = F.vert.begin (); it != F.vert.end (); ++it)
+                        for (int i = 0; i != (int)it->size (); i += 2)
+                            batch.add_vertex ((*it)[i], (*it)[i+1], label);
+                    batch.end_contour ();
+                    if (batch.num_edges () >= BATCH_EDGES) {
+                        sink->add_boundary (batch);
+                        batch.clear ();
+                    }
+                    F.vert.clear ();
+                    free_fragments.push_back (f);
+                } else {
+                    // join with the fragment which goes up from here
+                    fragment_t &G = fragments[g];
+                    F.vert.splice (F.vert.end (), G.vert);
+                    F.head_seam = G.head_seam;
+                    F.head_x = G.head_x;
+                    HEAD_AT (F.head_seam, F.head_x) = f;
+                    F.first_site = std::min (F.first_site, G.first_site);
+                    if (by_component)
+                        components.join (F.piece, G.piece);
+                    free_fragments.push_back (g);
+                }
+            } else if (exit_seam == y) {
+                // prepend to the fragment which goes up from here
+                int g = tail_at[exit_x];
+                assert (g != -1);
+                tail_at[exit_x] = -1;
+                fragment_t &G = fragments[g];
+                G.vert.push_front (std::vector <double> ());
+                G.vert.front ().swap (vert);
+                G.tail_seam = y+1;
+                G.tail_x = x;
+                G.first_site = std::min (G.first_site, site);
+                next_tail_at[x] = g;
+            } else {
+                // a new fragment, which comes up from below and goes
+                // down again
+                int f;
+                if (free_fragments.empty ()) {
+                    f = fragments.size ();
+                    fragments.push_back (fragment_t ());
+                } else {
+                    f = free_fragments.back ();
+                    free_fragments.pop_back ();
+                }
+                fragment_t &F = fragments[f];
+                F.vert.push_back (std::vector <double> ());
+                F.vert.back ().swap (vert);
+                F.tail_seam = y+1;
+                F.tail_x = x;
+                F.head_seam = y+1;
+                F.head_x = exit_x;
+                F.piece = by_component ? components.add () : 0;
+                F.first_site = site;
+                next_tail_at[x] = f;
+                next_head_at[exit_x] = f;
+            }
+        }
+        if (by_component) {
+            // the contours on both ends of a white stretch of the seam
+            // below bound the same component.
+            int prev = -1;
+            for (int x = 0; x != dualxmax; ++x) {
+                int f = next_head_at[x] != -1 ? next_head_at[x]
+                                              : next_tail_at[x];
+                if (f == -1)
+                    continue;
+                if (prev != -1 && is_white (x, y+1))
+                    components.join (fragments[prev].piece, fragments[f].piece);
+                prev = f;
+            }
+        }
+        head_at.swap (next_head_at);
+        tail_at.swap (next_tail_at);
+    }
+#undef HEAD_AT
+#undef TAIL_AT
+    assert (free_fragments.size () == fragments.size ());
+    if (batch.num_contours ())
+        sink->add_boundary (batch);
+    if (!by_component)
+        return 1;
+
+    // label_by_component numbers the outer contours in the order of
+    // marching_squares, which starts each contour at its first
+    // non-ambiguous site.
+    const int num_pieces = components.parent.size ();
+    std::vector <std::pair <long, int> > roots;
+    for (int p = 0; p != num_pieces; ++p)
+        if (components.find (p) == p)
+            roots.push_back (std::make_pair (components.outer_site[p], p));
+    std::sort (roots.begin (), roots.end ());
+    std::vector <int> root_label (num_pieces, -1);
+    for (int l = 0; l != (int)roots.size (); ++l)
+        root_label[roots[l].second] = l;
+    const int num_running = components.label_piece.size ();
+    std::vector <int> new_label (num_running);
+    for (int l = 0; l != num_running; ++l)
+        new_label[l] = root_label[components.find (components.label_piece[l])];
+    sink->merge_labels (new_label, roots.size ());
+    return roots.size ();
+}
+
+inline int MarchingSquares::components_t::add () {
+    parent.push_back (parent.size ());
+    outer_site.push_back (LONG_MAX);
+    label.push_back (-1);
+    return parent.size () - 1;
+}
+
+inline int MarchingSquares::components_t::find (int piece) {
+    while (parent[piece] != piece) {
+        parent[piece] = parent[parent[piece]];
+        piece = parent[piece];
+    }
+    return piece;
+}
+
+inline void MarchingSquares::components_t::join (int a, int b) {
+    a = find (a);
+    b = find (b);
+    if (a == b)
+        return;
+    parent[b] = a;
+    outer_site[a] = std::min (outer_site[a], outer_site[b]);
+    // if both have a label already, that of b stays in use for the
+    // contours closed so far, and is mapped to a at the end
+    if (label[a] == -1)
+        label[a] = label[b];
+}
+
+inline int MarchingSquares::components_t::label_of (int piece) {
+    const int root = find (piece);
+    if (label[root] == -1) {
+        label[root] = label_piece.size ();
+        label_piece.push_back (root);
+    }
+    return label[root];
+}
+
+// from the sign of the enclosed area
+bool MarchingSquares::is_counterclockwise (const fragment_t &F) {
+    double area = 0.;
+    double x0 = F.vert.front ()[0], y0 = F.vert.front ()[1];
+    double prevx = x0, prevy = y0;
+    std::list <std::vector <double> >::const_iterator it;
+    for (it = F.vert.begin (); it != F.vert.end (); ++it)
+        for (int i = 0; i != (int)it->size (); i += 2) {
+            area += prevx * (*it)[i+1] - (*it)[i] * prevy;
+            prevx = (*it)[i];
+            prevy = (*it)[i+1];
+        }
+    area += prevx * y0 - x0 * prevy;
+    return area > 0.;
+}
+
+
+// padded row y of the image, into rows[y%2]
+void MarchingSquares::load_row (PixmapRowSource *reader, int y,
+                                std::vector <val_t> *buffer) {
+    std::vector <val_t> &row = rows[y%2];
+    row.assign (xmap.size (), Pixmap::min_val ());
+    if (ymap[y] < 0)
+        return;
+    reader->read_row (ymap[y], &(*buffer)[0]);
+    for (int x = 0; x != (int)xmap.size (); ++x)
+        if (xmap[x] >= 0)
+            row[x] = (*buffer)[xmap[x]];
+}
+
+// follow a contour through row y, until it leaves the row.  returns the
+// seam it leaves through (y or y+1), and the column in *exit_x.  if
+// min_x is given, the leftmost non-ambiguous site visited is returned
+// there, or INT_MAX if there is none.
+int MarchingSquares::trace_row_chain (int thisx, int thisy,
+                                      int prevx, int prevy,
+                                      std::vector <double> *vert,
+                                      int *exit_x, int *min_x) {
+    const int y = thisy;
+    if (min_x)
+        *min_x = INT_MAX;
+    for (;;) {
+        int nextx, nexty;
+        double vertx, verty;
+        if (min_x && !is_ambiguous (square_type (thisx, y)))
+            *min_x = std::min (*min_x, thisx);
+        step (thisx, thisy, prevx, prevy, &nextx, &nexty, &vertx, &verty);
+        vert->push_back (vertex_x (vertx));
+        vert->push_back (vertex_y (verty));
+        if (nexty != y) {
+            *exit_x = nextx;
+            return std::max (y, nexty);
+        }
+        prevx = thisx;
+        prevy = thisy;
+        thisx = nextx;
+    }
+}
+
+//
+// threshold sweep for the scalar functionals.  the image is replaced by
+// a black and white one, in which the pixels are turned white in order of
+// decreasing value.  only the squares around a changed pixel change.
+//
+
+MarchingSquares::square_measures_t MarchingSquares::square_measures (int type) const {
+    square_measures_t ret = { 0, 0, 0, 0 };
+    switch (type) {
+    case 0:
+        break;
+    case UPPERLEFT|UPPERRIGHT|LOWERLEFT|LOWERRIGHT:
+        ret.area = 8;
+        break;
+    // one white corner is cut off, turning left
+    case UPPERLEFT:
+    case UPPERRIGHT:
+    case LOWERLEFT:
+    case LOWERRIGHT:
+        ret.area = 1;
+        ret.diagonal = 1;
+        ret.turns = 1;
+        break;
+    // one black corner is cut off, turning right
+    case UPPERRIGHT|LOWERLEFT|LOWERRIGHT:
+    case UPPERLEFT|LOWERLEFT|LOWERRIGHT:
+    case UPPERLEFT|UPPERRIGHT|LOWERRIGHT:
+    case UPPERLEFT|UPPERRIGHT|LOWERLEFT:
+        ret.area = 7;
+        ret.diagonal = 1;
+        ret.turns = -1;
+        break;
+    case UPPERLEFT|UPPERRIGHT:
+    case LOWERLEFT|LOWERRIGHT:
+    case LOWERLEFT|UPPERLEFT:
+    case LOWERRIGHT|UPPERRIGHT:
+        ret.area = 4;
+        ret.straight = 1;
+        break;
+    // ambiguous ones: either both white or both black corners are cut off
+    case UPPERLEFT|LOWERRIGHT:
+    case UPPERRIGHT|LOWERLEFT:
+        ret.area = connect_void ? 2 : 6;
+        ret.diagonal = 2;
+        ret.turns = connect_void ? 2 : -2;
+        break;
+    default:
+        never_reached ();
+    }
+    return ret;
+}
+
+// sorts pixel indices by decreasing value.  the indices are size_t,
+// since large images have 2^31 pixels and more.
+struct brighter_pixel {
+    const Pixmap *p;
+    bool operator() (size_t a, size_t b) const {
+        const size_t w = p->size1 ();
+        return (*p)(a%w, a/w) > (*p)(b%w, b/w);
+    }
+};
+
+// sorts threshold indices by decreasing threshold
+struct higher_threshold {
+    const std::vector <double> *t;
+    bool operator() (int a, int b) const {
+        return (*t)[a] > (*t)[b];
+    }
+};
+
+// the positions in the padded lattice of each image coordinate; with
+// periodic data, the first and last ones occur twice.
+void invert_padding_map (std::vector <int> *inv, const std::vector <int> &map,
+                         int size) {
+    inv->assign (2*size, -1);
+    for (int p = 0; p != (int)map.size (); ++p)
+        if (map[p] >= 0)
+            (*inv)[2*map[p] + ((*inv)[2*map[p]] != -1)] = p;
+}
+
+void MarchingSquares::run_level_set_sweep (std::vector <level_set_t> *out,
+                                           const Pixmap &image,
+                                           const std::vector <double> &thresholds) {
+    const int w = image.size1 (), h = image.size2 ();
+    // the pixels which are white so far, one bit each
+    Pixmap state;
+    state.resize_raw (w, h, 1);
+    state.init_zero ();
+    threshold = .5;
+    pad_dataset (state);
+    dualxmax = xmap.size () - 1;
+    dualymax = ymap.size () - 1;
+    std::vector <int> xinv, yinv;
+    invert_padding_map (&xinv, xmap, w);
+    invert_padding_map (&yinv, ymap, h);
+    square_measures_t measures[16];
+    for (int type = 0; type != 16; ++type)
+        measures[type] = square_measures (type);
+
+    std::vector <size_t> pixels (size_t (w) * h);
+    for (size_t i = 0; i != pixels.size (); ++i)
+        pixels[i] = i;
+    brighter_pixel by_pixel = { &image };
+    std::sort (pixels.begin (), pixels.end (), by_pixel);
+    std::vector <int> order (thresholds.size ());
+    for (int i = 0; i != (int)order.size (); ++i)
+        order[i] = i;
+    higher_threshold by_threshold = { &thresholds };
+    std::sort (order.begin (), order.end (), by_threshold);
+
+    long area = 0, straight = 0, diagonal = 0, turns = 0;
+    out->resize (thresholds.size ());
+    size_t next = 0;
+    for (int k = 0; k != (int)order.size (); ++k) {
+        const val_t t = thresholds[order[k]];
+        for (; next != pixels.size (); ++next) {
+            const int i = int (pixels[next] % w), j = int (pixels[next] / w);
+            if (! (image (i, j) > t))
+                break;
+            // the squares which have this pixel as one of their corners
+            int squares[16][2];
+            int num_squares = 0;
+            for (int a = 0; a != 2 && yinv[2*j+a] != -1; ++a)
+            for (int b = 0; b != 2 && xinv[2*i+b] != -1; ++b)
+            for (int dy = -1; dy != 1; ++dy)
+            for (int dx = -1; dx != 1; ++dx) {
+                const int x = xinv[2*i+b] + dx, y = yinv[2*j+a] + dy;
+                if (x < 0 || y < 0 || x >= dualxmax || y >= dualymax)
+                    continue;
+                // tiny periodic images touch some squares twice
+                int s = 0;
+                while (s != num_squares &&
+                       (squares[s][0] != x || squares[s][1] != y))
+                    ++s;
+                if (s != num_squares)
+                    continue;
+                squares[num_squares][0] = x;
+                squares[num_squares][1] = y;
+                ++num_squares;
+            }
+            for (int s = 0; s != num_squares; ++s) {
+                const square_measures_t &m = measures[square_type (squares[s][0], squares[s][1])];
+                area -= m.area;
+                straight -= m.straight;
+                diagonal -= m.diagonal;
+                turns -= m.turns;
+            }
+            state.set_raw (i, j, 1);
+            for (int s = 0; s != num_squares; ++s) {
+                const square_measures_t &m = measures[square_type (squares[s][0], squares[s][1])];
+                area += m.area;
+                straight += m.straight;
+                diagonal += m.diagonal;
+                turns += m.turns;
+            }
+        }
+        assert (turns % 4 == 0);
+        level_set_t &l = (*out)[order[k]];
+        l.threshold = thresholds[order[k]];
+        l.area = area / 8.;
+        l.perimeter = straight + diagonal * M_SQRT1_2;
+        l.euler = turns / 4;
+    }
+}
+
+inline int MarchingSquares::square_type (int x, int y) {
+    // determine which kind of boundary we found
+    // in type, all "white" pixels are set
+    int type;
+    type  = is_white (x,   y)   * UPPERLEFT;
+    type |= is_white (x+1, y)   * UPPERRIGHT;
+    type |= is_white (x,   y+1) * LOWERLEFT;
+    type |= is_white (x+1, y+1) * LOWERRIGHT;
+    return type;
+}
+
+inline bool MarchingSquares::is_white (int x, int y) const {
+    if (!raw_dataset)
+        return pixel (x, y) > threshold;
+    const int i = xmap[x], j = ymap[y];
+    return i >= 0 && j >= 0 && dataset->raw (i, j) > raw_threshold;
 }
 
 inline void MarchingSquares::log (const char *fmt, ...) {
@@ -294,9 +1156,26 @@ inline void MarchingSquares::log (const char *fmt, ...) {
 
 }
 
+int streaming_marching_squares (FrozenBoundarySink *sink,
+                                PixmapRowSource *reader,
+                                Pixmap::val_t threshold,
+                                bool connect_void, bool periodic_data,
+                                bool by_component, bool interpolate) {
+    MarchingSquares m (connect_void, periodic_data, interpolate);
+    return m.run_streaming (sink, reader, threshold, by_component);
+}
+
+void level_set_sweep (std::vector <level_set_t> *out, const Pixmap &p,
+                      const std::vector <double> &thresholds,
+                      bool connect_void, bool periodic_data) {
+    MarchingSquares m (connect_void, periodic_data);
+    m.run_level_set_sweep (out, p, thresholds);
+}
+
 void marching_squares (Boundary *b, const Pixmap &p,
                        Pixmap::val_t threshold,
-                       bool connect_void, bool periodic_data) {
-    MarchingSquares m (connect_void, periodic_data);
-    m.run (b, p, threshold);
+                       bool connect_void, bool periodic_data,
+                       int num_threads, bool interpolate) {
+    MarchingSquares m (connect_void, periodic_data, interpolate);
+    m.run (b, p, threshold, num_threads);
 }
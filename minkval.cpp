@@ -1,5 +1,12 @@
 #include "minkval.h"
 #include <math.h>
+#include <pthread.h>
+#include <stdexcept>
+
+#if defined (__GNUC__) && (defined (__x86_64__) || defined (__i386__))
+#define HAVE_AVX_KERNELS
+#include <immintrin.h>
+#endif
 
 // change the 1 to a 0 in order to use the normalization
 // described in the paper
@@ -15,6 +22,8 @@ double W1_NORMALIZATION = .5;
 double W2_NORMALIZATION = .5;
 #endif
 
+bool USE_SIMD_KERNELS = true;
+
 
 void print_version_header (std::ostream &of) {
     of << "# papaya version " << VERSION <<
@@ -411,3 +420,924 @@ MatrixMinkowskiFunctional *create_w120 () { return new W120; }
 MatrixMinkowskiFunctional *create_w102 () { return new W102; }
 MatrixMinkowskiFunctional *create_w220 () { return new W220; }
 MatrixMinkowskiFunctional *create_w211 () { return new W211; }
+
+
+//
+// fused evaluation of all the functionals
+//
+
+FusedMinkowskiFunctionals::FusedMinkowskiFunctionals ()
+    : w000 (0), w100 (0), w200 (0),
+      w010 (0), w110 (0), w210 (0),
+      w020 (0), w120 (0), w102 (0), w220 (0), w211 (0),
+      num_threads (1) {
+}
+
+// fill in everything except the inflection angles
+static inline void load_edge_data (FusedMinkowskiFunctionals::edge_data_t *e,
+                                   const Boundary &b,
+                                   Boundary::edge_iterator it) {
+    e->label = b.edge_label (it);
+    e->vert0 = b.edge_vertex0 (it);
+    e->vert1 = b.edge_vertex1 (it);
+    e->tangent = e->vert1;
+    e->tangent -= e->vert0;
+    e->length = e->tangent.norm ();
+    e->tangent /= e->length;
+    e->normal = vec_t (e->tangent[1], -e->tangent[0]);
+}
+
+// read everything from the geometry cache of the Boundary.
+static inline void load_cached_edge_data (FusedMinkowskiFunctionals::edge_data_t *e,
+                                          const Boundary &b,
+                                          Boundary::edge_iterator it) {
+    e->label = b.edge_label (it);
+    e->vert0 = b.edge_vertex0 (it);
+    e->vert1 = b.edge_vertex1 (it);
+    e->length = b.edge_length (it);
+    e->tangent = b.edge_tangent (it);
+    e->normal = vec_t (e->tangent[1], -e->tangent[0]);
+}
+
+void FusedMinkowskiFunctionals::add_contour (const Boundary &b,
+                                             edge_iterator pos,
+                                             edge_iterator end) {
+    if (pos == end)
+        return;
+    // the atan2 calls are skipped if nobody needs the angles.
+    const bool inflections = needs_inflections ();
+    if (b.geometry_is_cached ()) {
+        edge_data_t e;
+        e.infl_after = inflections ? b.inflection_before_edge (pos) : 0.;
+        for (; pos != end; ++pos) {
+            load_cached_edge_data (&e, b, pos);
+            e.infl_before = e.infl_after;
+            e.infl_after = inflections ? b.inflection_after_edge (pos) : 0.;
+            add_edge (e);
+        }
+        return;
+    }
+    edge_data_t cur, next;
+    load_edge_data (&cur, b, pos);
+    const vec_t first_tangent = cur.tangent;
+    cur.infl_before = 0.;
+    if (inflections) {
+        // the inflection at vert0 of the first edge
+        edge_iterator prev = pos;
+        --prev;
+        load_edge_data (&next, b, prev);
+        cur.infl_before = inflection_angle (next.tangent, cur.tangent);
+    }
+    for (;;) {
+        edge_iterator succ = pos;
+        ++succ;
+        if (succ == end) {
+            cur.infl_after = inflections
+                ? inflection_angle (cur.tangent, first_tangent) : 0.;
+            add_edge (cur);
+            return;
+        }
+        load_edge_data (&next, b, succ);
+        cur.infl_after = inflections
+            ? inflection_angle (cur.tangent, next.tangent) : 0.;
+        add_edge (cur);
+        next.infl_before = cur.infl_after;
+        cur = next;
+        pos = succ;
+    }
+}
+
+void FusedMinkowskiFunctionals::add_boundary (const Boundary &b) {
+    if (empty ())
+        return;
+    Boundary::contour_iterator cit;
+    for (cit = b.contours_begin (); cit != b.contours_end (); ++cit)
+        add_contour (b, b.edges_begin (cit), b.edges_end (cit));
+}
+
+// edge i of a FrozenBoundary, running to vertex j
+static inline void load_frozen_edge_data (FusedMinkowskiFunctionals::edge_data_t *e,
+                                          const FrozenBoundary &b,
+                                          int i, int j) {
+    e->label = b.labels ()[i];
+    e->vert0 = vec_t (b.x ()[i], b.y ()[i]);
+    e->vert1 = vec_t (b.x ()[j], b.y ()[j]);
+    if (b.has_geometry ()) {
+        // from the geometry cache of the Boundary
+        e->length = b.lengths ()[i];
+        e->tangent = vec_t (b.tangent_x ()[i], b.tangent_y ()[i]);
+    } else {
+        e->tangent = e->vert1;
+        e->tangent -= e->vert0;
+        e->length = e->tangent.norm ();
+        e->tangent /= e->length;
+    }
+    e->normal = vec_t (e->tangent[1], -e->tangent[0]);
+}
+
+// the inflection after edge i of a FrozenBoundary, whose tangent is t0,
+// while the next one has tangent t1
+static inline double frozen_inflection (const FrozenBoundary &b, int i,
+                                        const vec_t &t0, const vec_t &t1) {
+    return b.has_geometry () ? b.inflections ()[i] : inflection_angle (t0, t1);
+}
+
+void FusedMinkowskiFunctionals::add_contour (const FrozenBoundary &b,
+                                             int contour) {
+    add_edges (b, contour, b.contour_begin (contour), b.contour_end (contour));
+}
+
+void FusedMinkowskiFunctionals::add_edges (const FrozenBoundary &b, int contour,
+                                           int first, int last) {
+    if (USE_SIMD_KERNELS && has_polygon_sums () && simd_kernels_available ()) {
+        add_polygon_sums_simd_ (b, contour, first, last);
+        // the curvature functionals take the scalar path
+        FusedMinkowskiFunctionals curvature;
+        curvature.w200 = w200;
+        curvature.w210 = w210;
+        curvature.w220 = w220;
+        if (!curvature.empty ())
+            curvature.add_edges_scalar_ (b, contour, first, last);
+    } else {
+        add_edges_scalar_ (b, contour, first, last);
+    }
+}
+
+void FusedMinkowskiFunctionals::add_edges_scalar_ (const FrozenBoundary &b,
+                                                   int contour,
+                                                   int first, int last) {
+    const int begin = b.contour_begin (contour);
+    const int end   = b.contour_end (contour);
+    if (first == last)
+        return;
+    const bool inflections = needs_inflections ();
+    edge_data_t cur, next;
+    load_frozen_edge_data (&cur, b, first, first+1 == end ? begin : first+1);
+    cur.infl_before = 0.;
+    if (inflections) {
+        const int prev = first == begin ? end-1 : first-1;
+        load_frozen_edge_data (&next, b, prev, prev+1 == end ? begin : prev+1);
+        cur.infl_before = frozen_inflection (b, prev, next.tangent, cur.tangent);
+    }
+    for (int i = first+1; i != last; ++i) {
+        load_frozen_edge_data (&next, b, i, i+1 == end ? begin : i+1);
+        cur.infl_after = inflections
+            ? frozen_inflection (b, i-1, cur.tangent, next.tangent) : 0.;
+        add_edge (cur);
+        next.infl_before = cur.infl_after;
+        cur = next;
+    }
+    cur.infl_after = 0.;
+    if (inflections) {
+        const int succ = last == end ? begin : last;
+        load_frozen_edge_data (&next, b, succ, succ+1 == end ? begin : succ+1);
+        cur.infl_after = frozen_inflection (b, last-1, cur.tangent, next.tangent);
+    }
+    add_edge (cur);
+}
+
+void FusedMinkowskiFunctionals::add_edge_range (const FrozenBoundary &b,
+                                                int first, int last) {
+    if (first == last)
+        return;
+    // find the contour which contains the first edge
+    int lo = 0, hi = b.num_contours ();
+    while (hi - lo > 1) {
+        int mid = (lo + hi) / 2;
+        if (b.contour_begin (mid) <= first)
+            lo = mid;
+        else
+            hi = mid;
+    }
+    for (int c = lo; first != last; ++c) {
+        int stop = std::min (b.contour_end (c), last);
+        add_edges (b, c, first, stop);
+        first = stop;
+    }
+}
+
+void FusedMinkowskiFunctionals::add_boundary (const FrozenBoundary &b) {
+    if (empty ())
+        return;
+    int n = std::min (num_threads, b.num_edges ());
+    if (n > 1) {
+        add_boundary_parallel_ (b, n);
+    } else {
+        for (int c = 0; c != b.num_contours (); ++c)
+            add_contour (b, c);
+    }
+}
+
+namespace {
+
+// a private copy of a functional, which collects the contributions
+// of a single thread.
+template <typename VALUE_TYPE>
+class PartialSum : public GenericMinkowskiFunctional <VALUE_TYPE> {
+public:
+    typedef GenericMinkowskiFunctional <VALUE_TYPE> base_t;
+    typedef AbstractMinkowskiFunctional::edge_iterator edge_iterator;
+
+    explicit PartialSum (const base_t &f)
+        : base_t (f) {
+        this->clear ();
+    }
+
+    void add_contour (const Boundary &, edge_iterator, edge_iterator) {
+        never_reached ();
+    }
+};
+
+template <typename VALUE_TYPE>
+void make_partial_sum (GenericMinkowskiFunctional <VALUE_TYPE> **partial,
+                       const GenericMinkowskiFunctional <VALUE_TYPE> *f) {
+    *partial = f ? new PartialSum <VALUE_TYPE> (*f) : 0;
+}
+
+template <typename VALUE_TYPE>
+void merge_partial_sum (GenericMinkowskiFunctional <VALUE_TYPE> *f,
+                        GenericMinkowskiFunctional <VALUE_TYPE> *partial) {
+    if (f) {
+        f->add_values (*partial);
+        delete partial;
+    }
+}
+
+struct edge_range_job_t {
+    const FrozenBoundary *b;
+    int first, last;
+    FusedMinkowskiFunctionals f;
+    // whether die () throws in the calling thread, and the message if it
+    // did in this job
+    bool die_throws;
+    std::string error;
+};
+
+extern "C" void *edge_range_thread (void *arg) {
+    edge_range_job_t *job = (edge_range_job_t *)arg;
+    DieThrows die_throws (job->die_throws);
+    try {
+        job->f.add_edge_range (*job->b, job->first, job->last);
+    } catch (std::exception &e) {
+        job->error = e.what ();
+    }
+    return 0;
+}
+
+} // namespace
+
+void FusedMinkowskiFunctionals::add_boundary_parallel_ (const FrozenBoundary &b,
+                                                        int n) {
+    // split the edges into n ranges of equal size, regardless of
+    // the contours.
+    std::vector <edge_range_job_t> jobs (n);
+    for (int t = 0; t != n; ++t) {
+        edge_range_job_t &job = jobs[t];
+        job.b = &b;
+        job.first = int (size_t (b.num_edges ()) * t / n);
+        job.last  = int (size_t (b.num_edges ()) * (t+1) / n);
+        job.die_throws = die_throws ();
+        make_partial_sum (&job.f.w000, w000);
+        make_partial_sum (&job.f.w100, w100);
+        make_partial_sum (&job.f.w200, w200);
+        make_partial_sum (&job.f.w010, w010);
+        make_partial_sum (&job.f.w110, w110);
+        make_partial_sum (&job.f.w210, w210);
+        make_partial_sum (&job.f.w020, w020);
+        make_partial_sum (&job.f.w120, w120);
+        make_partial_sum (&job.f.w102, w102);
+        make_partial_sum (&job.f.w220, w220);
+        make_partial_sum (&job.f.w211, w211);
+    }
+
+    // the calling thread takes the first range.
+    std::vector <pthread_t> threads (n);
+    for (int t = 1; t != n; ++t)
+        if (pthread_create (&threads[t], 0, &edge_range_thread, &jobs[t]))
+            die ("FusedMinkowskiFunctionals: unable to create thread");
+    edge_range_thread (&jobs[0]);
+    for (int t = 1; t != n; ++t)
+        pthread_join (threads[t], 0);
+
+    // add up in a fixed order
+    for (int t = 0; t != n; ++t) {
+        edge_range_job_t &job = jobs[t];
+        merge_partial_sum (w000, job.f.w000);
+        merge_partial_sum (w100, job.f.w100);
+        merge_partial_sum (w200, job.f.w200);
+        merge_partial_sum (w010, job.f.w010);
+        merge_partial_sum (w110, job.f.w110);
+        merge_partial_sum (w210, job.f.w210);
+        merge_partial_sum (w020, job.f.w020);
+        merge_partial_sum (w120, job.f.w120);
+        merge_partial_sum (w102, job.f.w102);
+        merge_partial_sum (w220, job.f.w220);
+        merge_partial_sum (w211, job.f.w211);
+    }
+    // only now, so that the partial sums are deleted
+    for (int t = 0; t != n; ++t)
+        if (!jobs[t].error.empty ())
+            die ("%s", jobs[t].error.c_str ());
+}
+
+template <typename VALUE_TYPE>
+static void merge_labels_of (GenericMinkowskiFunctional <VALUE_TYPE> *f,
+                             const std::vector <int> &new_label,
+                             int num_labels) {
+    if (f)
+        f->merge_labels (new_label, num_labels);
+}
+
+void FusedMinkowskiFunctionals::merge_labels (const std::vector <int> &new_label,
+                                              int num_labels) {
+    merge_labels_of (w000, new_label, num_labels);
+    merge_labels_of (w100, new_label, num_labels);
+    merge_labels_of (w200, new_label, num_labels);
+    merge_labels_of (w010, new_label, num_labels);
+    merge_labels_of (w110, new_label, num_labels);
+    merge_labels_of (w210, new_label, num_labels);
+    merge_labels_of (w020, new_label, num_labels);
+    merge_labels_of (w120, new_label, num_labels);
+    merge_labels_of (w102, new_label, num_labels);
+    merge_labels_of (w220, new_label, num_labels);
+    merge_labels_of (w211, new_label, num_labels);
+}
+
+void FusedMinkowskiFunctionals::add_sums (int l, const minkowski_sums_t &s) {
+    if (w000) w000->acc (l) += s.w000;
+    if (w100) w100->acc (l) += s.w100;
+    if (w200) w200->acc (l) += s.w200;
+    if (w010) w010->acc (l) += s.w010;
+    if (w110) w110->acc (l) += s.w110;
+    if (w210) w210->acc (l) += s.w210;
+    if (w020) w020->acc (l) += s.w020;
+    if (w120) w120->acc (l) += s.w120;
+    if (w102) w102->acc (l) += s.w102;
+    if (w220) w220->acc (l) += s.w220;
+    if (w211) w211->acc (l) += s.w211;
+}
+
+// the formulas below are copied from the individual functionals,
+// keeping the order of operations so the results agree exactly.
+void FusedMinkowskiFunctionals::add_edge (const edge_data_t &e) {
+    const int l = e.label;
+    // unlabelled edges would only go to the dummy accumulators, which are
+    // shared between threads.
+    if (l == Boundary::NO_LABEL)
+        return;
+    if (w000) {
+        vec_t edge_grav = e.vert0;
+        edge_grav += e.vert1;
+        edge_grav *= .25 * e.length;
+        double sc = dot (e.normal, edge_grav);
+        sc *= W0_NORMALIZATION;
+        w000->acc (l) += sc;
+    }
+    if (w100) {
+        w100->acc (l) += e.length * W1_NORMALIZATION;
+    }
+    if (w200) {
+        w200->acc (l) += e.infl_after * W2_NORMALIZATION;
+    }
+    if (w010) {
+        const vec_t &v1 = e.vert1 - w010->ref_vertex (l);
+        const vec_t &v0 = e.vert0 - w010->ref_vertex (l);
+        vec_t first_factor = v1;
+        first_factor -= v0;
+        first_factor *= W0_NORMALIZATION / 6.;
+        vec_t second_factor;
+        second_factor[0] = v1[0]*v1[0] + v0[0]*v0[0] + v0[0]*v1[0];
+        second_factor[1] = v1[1]*v1[1] + v0[1]*v0[1] + v0[1]*v1[1];
+        vec_t &acc_ = w010->acc (l);
+        acc_[0] +=  first_factor[1] * second_factor[0];
+        acc_[1] += -first_factor[0] * second_factor[1];
+    }
+    if (w110) {
+        vec_t avgvert = e.vert1;
+        avgvert += e.vert0;
+        avgvert /= 2;
+        avgvert -= w110->ref_vertex (l);
+        w110->acc (l) += (W1_NORMALIZATION * e.length) * avgvert;
+    }
+    if (w210) {
+        vec_t vert = e.vert1;
+        vert -= w210->ref_vertex (l);
+        w210->acc (l) += (W2_NORMALIZATION * e.infl_after) * vert;
+    }
+    if (w211) {
+        mat_t incr;
+        vec_t edgevec = e.vert1;
+        edgevec -= e.vert0;
+        dyadic_prod_self (&incr, edgevec);
+        incr *= W2_NORMALIZATION / e.length;
+        w211->acc (l) += incr;
+    }
+    if (w220) {
+        const double prefactor = .5 * W2_NORMALIZATION;
+        mat_t incr;
+        vec_t loc = e.vert1;
+        loc -= w220->ref_vertex (l);
+        dyadic_prod_self (&incr, loc);
+        incr *= prefactor * e.infl_after;
+        w220->acc (l) += incr;
+        loc = e.vert0;
+        loc -= w220->ref_vertex (l);
+        dyadic_prod_self (&incr, loc);
+        incr *= prefactor * e.infl_before;
+        w220->acc (l) += incr;
+    }
+    if (w120) {
+        mat_t &acc_ = w120->acc (l);
+        mat_t incr;
+        double l_prefactor = W1_NORMALIZATION / 3. * e.length;
+        vec_t loc1 = e.vert1;
+        loc1 -= w120->ref_vertex (l);
+        dyadic_prod_self (&incr, loc1);
+        incr *= l_prefactor;
+        acc_ += incr;
+        vec_t loc0 = e.vert0;
+        loc0 -= w120->ref_vertex (l);
+        dyadic_prod_self (&incr, loc0);
+        incr *= l_prefactor;
+        acc_ += incr;
+        dyadic_prod_symmetrized (&incr, loc0, loc1);
+        incr *= l_prefactor;
+        acc_ += incr;
+    }
+    if (w102) {
+        mat_t &acc_ = w102->acc (l);
+        mat_t incr;
+        dyadic_prod_self (&incr, e.normal);
+        incr *= e.length * W1_NORMALIZATION;
+        acc_ += incr;
+    }
+    if (w020) {
+        const vec_t &v1 = e.vert1 - w020->ref_vertex (l);
+        const vec_t &v0 = e.vert0 - w020->ref_vertex (l);
+        mat_t &acc_ = w020->acc (l);
+        double prefactor = W0_NORMALIZATION / 12. * (v1[1] - v0[1]);
+        acc_(0,0) += prefactor * (v0[0] + v1[0]) * (v0[0]*v0[0] + v1[0]*v1[0]);
+        double t = v0[0]*v0[0] * (3.*v0[1] + v1[1]);
+        t += v1[0]*v1[0] * (3.*v1[1] + v0[1]);
+        t *= .5;
+        t +=  v0[0] * v1[0]  * (v0[1] + v1[1]);
+        acc_(0,1) += prefactor * t;
+        acc_(1,0) = acc_(0,1);
+        prefactor = W0_NORMALIZATION / 12. * (v0[0] - v1[0]);
+        acc_(1,1) += prefactor * (v0[1] + v1[1]) * (v0[1]*v0[1] + v1[1]*v1[1]);
+    }
+}
+
+
+//
+// vectorized kernels for the polygon-sum functionals
+//
+
+namespace {
+
+// sums over a run of edges, without the normalization prefactors.
+// the symmetric matrices are stored as xx, xy, yy.
+struct polygon_sums_t {
+    double w000, w100;
+    double w010[2], w110[2];
+    double w020[3], w120[3];
+    // dx dx / length, dx dy / length, dy dy / length;
+    // W211 and (rotated) W102 are built from these
+    double dd[3];
+};
+
+// reference vertices of the position-dependent functionals
+struct polygon_refs_t {
+    double w010[2], w110[2], w020[2], w120[2];
+};
+
+enum {
+    SUM_W000 = 1, SUM_W100 = 2, SUM_W010 = 4, SUM_W110 = 8,
+    SUM_W020 = 16, SUM_W120 = 32, SUM_DD = 64
+};
+
+#ifdef HAVE_AVX_KERNELS
+
+__attribute__ ((target ("avx")))
+static inline double hsum (__m256d v) {
+    double lane[4];
+    _mm256_storeu_pd (lane, v);
+    return (lane[0] + lane[1]) + (lane[2] + lane[3]);
+}
+
+// sum up edges i = 0...n-1 running from (x[i],y[i]) to (x[i+1],y[i+1]).
+// n must be a multiple of 4.
+__attribute__ ((target ("avx")))
+static void polygon_sums_avx (polygon_sums_t *sums, const double *x,
+                              const double *y, int n,
+                              const polygon_refs_t &ref, int which) {
+    const __m256d zero = _mm256_setzero_pd ();
+    const __m256d half = _mm256_set1_pd (.5);
+    const __m256d three = _mm256_set1_pd (3.);
+    __m256d s000 = zero, s100 = zero;
+    __m256d s010x = zero, s010y = zero, s110x = zero, s110y = zero;
+    __m256d s020xx = zero, s020xy = zero, s020yy = zero;
+    __m256d s120xx = zero, s120xy = zero, s120yy = zero;
+    __m256d sddxx = zero, sddxy = zero, sddyy = zero;
+    for (int i = 0; i < n; i += 4) {
+        const __m256d x0 = _mm256_loadu_pd (x + i);
+        const __m256d x1 = _mm256_loadu_pd (x + i + 1);
+        const __m256d y0 = _mm256_loadu_pd (y + i);
+        const __m256d y1 = _mm256_loadu_pd (y + i + 1);
+        const __m256d dx = _mm256_sub_pd (x1, x0);
+        const __m256d dy = _mm256_sub_pd (y1, y0);
+        const __m256d len = _mm256_sqrt_pd (
+            _mm256_add_pd (_mm256_mul_pd (dx, dx), _mm256_mul_pd (dy, dy)));
+        if (which & SUM_W000) {
+            s000 = _mm256_add_pd (s000, _mm256_sub_pd (
+                _mm256_mul_pd (dy, _mm256_add_pd (x0, x1)),
+                _mm256_mul_pd (dx, _mm256_add_pd (y0, y1))));
+        }
+        if (which & SUM_W100) {
+            s100 = _mm256_add_pd (s100, len);
+        }
+        if (which & SUM_DD) {
+            const __m256d ilen = _mm256_div_pd (_mm256_set1_pd (1.), len);
+            sddxx = _mm256_add_pd (sddxx, _mm256_mul_pd (_mm256_mul_pd (dx, dx), ilen));
+            sddxy = _mm256_add_pd (sddxy, _mm256_mul_pd (_mm256_mul_pd (dx, dy), ilen));
+            sddyy = _mm256_add_pd (sddyy, _mm256_mul_pd (_mm256_mul_pd (dy, dy), ilen));
+        }
+        if (which & SUM_W010) {
+            const __m256d rx = _mm256_set1_pd (ref.w010[0]);
+            const __m256d ry = _mm256_set1_pd (ref.w010[1]);
+            const __m256d u0 = _mm256_sub_pd (x0, rx), u1 = _mm256_sub_pd (x1, rx);
+            const __m256d v0 = _mm256_sub_pd (y0, ry), v1 = _mm256_sub_pd (y1, ry);
+            // u1^2 + u0^2 + u0 u1
+            const __m256d sfx = _mm256_add_pd (_mm256_add_pd (
+                _mm256_mul_pd (u1, u1), _mm256_mul_pd (u0, u0)), _mm256_mul_pd (u0, u1));
+            const __m256d sfy = _mm256_add_pd (_mm256_add_pd (
+                _mm256_mul_pd (v1, v1), _mm256_mul_pd (v0, v0)), _mm256_mul_pd (v0, v1));
+            s010x = _mm256_add_pd (s010x, _mm256_mul_pd (dy, sfx));
+            s010y = _mm256_add_pd (s010y, _mm256_mul_pd (dx, sfy));
+        }
+        if (which & SUM_W110) {
+            const __m256d rx = _mm256_set1_pd (ref.w110[0]);
+            const __m256d ry = _mm256_set1_pd (ref.w110[1]);
+            const __m256d u0 = _mm256_sub_pd (x0, rx), u1 = _mm256_sub_pd (x1, rx);
+            const __m256d v0 = _mm256_sub_pd (y0, ry), v1 = _mm256_sub_pd (y1, ry);
+            s110x = _mm256_add_pd (s110x, _mm256_mul_pd (len, _mm256_add_pd (u0, u1)));
+            s110y = _mm256_add_pd (s110y, _mm256_mul_pd (len, _mm256_add_pd (v0, v1)));
+        }
+        if (which & SUM_W120) {
+            const __m256d rx = _mm256_set1_pd (ref.w120[0]);
+            const __m256d ry = _mm256_set1_pd (ref.w120[1]);
+            const __m256d u0 = _mm256_sub_pd (x0, rx), u1 = _mm256_sub_pd (x1, rx);
+            const __m256d v0 = _mm256_sub_pd (y0, ry), v1 = _mm256_sub_pd (y1, ry);
+            const __m256d xx = _mm256_add_pd (_mm256_add_pd (
+                _mm256_mul_pd (u1, u1), _mm256_mul_pd (u0, u0)), _mm256_mul_pd (u0, u1));
+            const __m256d yy = _mm256_add_pd (_mm256_add_pd (
+                _mm256_mul_pd (v1, v1), _mm256_mul_pd (v0, v0)), _mm256_mul_pd (v0, v1));
+            const __m256d xy = _mm256_add_pd (_mm256_add_pd (
+                _mm256_mul_pd (u1, v1), _mm256_mul_pd (u0, v0)),
+                _mm256_mul_pd (half, _mm256_add_pd (
+                    _mm256_mul_pd (u0, v1), _mm256_mul_pd (v0, u1))));
+            s120xx = _mm256_add_pd (s120xx, _mm256_mul_pd (len, xx));
+            s120xy = _mm256_add_pd (s120xy, _mm256_mul_pd (len, xy));
+            s120yy = _mm256_add_pd (s120yy, _mm256_mul_pd (len, yy));
+        }
+        if (which & SUM_W020) {
+            const __m256d rx = _mm256_set1_pd (ref.w020[0]);
+            const __m256d ry = _mm256_set1_pd (ref.w020[1]);
+            const __m256d u0 = _mm256_sub_pd (x0, rx), u1 = _mm256_sub_pd (x1, rx);
+            const __m256d v0 = _mm256_sub_pd (y0, ry), v1 = _mm256_sub_pd (y1, ry);
+            const __m256d u0u0 = _mm256_mul_pd (u0, u0), u1u1 = _mm256_mul_pd (u1, u1);
+            const __m256d v0v0 = _mm256_mul_pd (v0, v0), v1v1 = _mm256_mul_pd (v1, v1);
+            // (u0 + u1) (u0^2 + u1^2)
+            const __m256d xx = _mm256_mul_pd (_mm256_add_pd (u0, u1),
+                                              _mm256_add_pd (u0u0, u1u1));
+            const __m256d yy = _mm256_mul_pd (_mm256_add_pd (v0, v1),
+                                              _mm256_add_pd (v0v0, v1v1));
+            // .5 (u0^2 (3 v0 + v1) + u1^2 (3 v1 + v0)) + u0 u1 (v0 + v1)
+            __m256d t = _mm256_add_pd (
+                _mm256_mul_pd (u0u0, _mm256_add_pd (_mm256_mul_pd (three, v0), v1)),
+                _mm256_mul_pd (u1u1, _mm256_add_pd (_mm256_mul_pd (three, v1), v0)));
+            t = _mm256_add_pd (_mm256_mul_pd (half, t), _mm256_mul_pd (
+                _mm256_mul_pd (u0, u1), _mm256_add_pd (v0, v1)));
+            s020xx = _mm256_add_pd (s020xx, _mm256_mul_pd (dy, xx));
+            s020xy = _mm256_add_pd (s020xy, _mm256_mul_pd (dy, t));
+            s020yy = _mm256_add_pd (s020yy, _mm256_mul_pd (dx, yy));
+        }
+    }
+    sums->w000 += hsum (s000);
+    sums->w100 += hsum (s100);
+    sums->w010[0] += hsum (s010x);
+    sums->w010[1] += hsum (s010y);
+    sums->w110[0] += hsum (s110x);
+    sums->w110[1] += hsum (s110y);
+    sums->w020[0] += hsum (s020xx);
+    sums->w020[1] += hsum (s020xy);
+    sums->w020[2] += hsum (s020yy);
+    sums->w120[0] += hsum (s120xx);
+    sums->w120[1] += hsum (s120xy);
+    sums->w120[2] += hsum (s120yy);
+    sums->dd[0] += hsum (sddxx);
+    sums->dd[1] += hsum (sddxy);
+    sums->dd[2] += hsum (sddyy);
+}
+
+#endif // HAVE_AVX_KERNELS
+
+} // namespace
+
+bool simd_kernels_available () {
+#ifdef HAVE_AVX_KERNELS
+    static const bool avx = __builtin_cpu_supports ("avx");
+    return avx;
+#else
+    return false;
+#endif
+}
+
+void FusedMinkowskiFunctionals::add_polygon_sums_simd_ (const FrozenBoundary &b,
+                                                        int contour,
+                                                        int first, int last) {
+    // edges which are left over are handled by the scalar code
+    FusedMinkowskiFunctionals rest = *this;
+    rest.w200 = 0;
+    rest.w210 = 0;
+    rest.w220 = 0;
+    edge_data_t e;
+    e.infl_before = e.infl_after = 0.;
+
+    const int begin = b.contour_begin (contour);
+    const int end   = b.contour_end (contour);
+    const int *label = b.labels ();
+    int which = 0;
+    which |= w000 ? SUM_W000 : 0;
+    which |= w100 ? SUM_W100 : 0;
+    which |= w010 ? SUM_W010 : 0;
+    which |= w110 ? SUM_W110 : 0;
+    which |= w020 ? SUM_W020 : 0;
+    which |= w120 ? SUM_W120 : 0;
+    which |= (w102 || w211) ? SUM_DD : 0;
+
+    // runs of equally labelled edges, except the last edge of the contour
+    // which wraps around to the first vertex
+    const int stop = std::min (last, end - 1);
+    int i = first;
+    while (i < stop) {
+        const int l = label[i];
+        int k = i + 1;
+        while (k < stop && label[k] == l)
+            ++k;
+        if (l == Boundary::NO_LABEL) {
+            i = k;
+            continue;
+        }
+        const int n = (k - i) / 4 * 4;
+        if (n) {
+            polygon_refs_t ref = polygon_refs_t ();
+            if (w010) {
+                ref.w010[0] = w010->ref_vertex (l)[0];
+                ref.w010[1] = w010->ref_vertex (l)[1];
+            }
+            if (w110) {
+                ref.w110[0] = w110->ref_vertex (l)[0];
+                ref.w110[1] = w110->ref_vertex (l)[1];
+            }
+            if (w020) {
+                ref.w020[0] = w020->ref_vertex (l)[0];
+                ref.w020[1] = w020->ref_vertex (l)[1];
+            }
+            if (w120) {
+                ref.w120[0] = w120->ref_vertex (l)[0];
+                ref.w120[1] = w120->ref_vertex (l)[1];
+            }
+            polygon_sums_t sums = polygon_sums_t ();
+#ifdef HAVE_AVX_KERNELS
+            polygon_sums_avx (&sums, b.x () + i, b.y () + i, n, ref, which);
+#else
+            never_reached ();
+#endif
+            if (w000)
+                w000->acc (l) += .25 * W0_NORMALIZATION * sums.w000;
+            if (w100)
+                w100->acc (l) += W1_NORMALIZATION * sums.w100;
+            if (w010) {
+                vec_t &acc_ = w010->acc (l);
+                acc_[0] += W0_NORMALIZATION / 6. * sums.w010[0];
+                acc_[1] -= W0_NORMALIZATION / 6. * sums.w010[1];
+            }
+            if (w110) {
+                vec_t &acc_ = w110->acc (l);
+                acc_[0] += .5 * W1_NORMALIZATION * sums.w110[0];
+                acc_[1] += .5 * W1_NORMALIZATION * sums.w110[1];
+            }
+            if (w020) {
+                mat_t &acc_ = w020->acc (l);
+                acc_(0,0) += W0_NORMALIZATION / 12. * sums.w020[0];
+                acc_(0,1) += W0_NORMALIZATION / 12. * sums.w020[1];
+                acc_(1,0) = acc_(0,1);
+                acc_(1,1) -= W0_NORMALIZATION / 12. * sums.w020[2];
+            }
+            if (w120) {
+                mat_t &acc_ = w120->acc (l);
+                acc_(0,0) += W1_NORMALIZATION / 3. * sums.w120[0];
+                acc_(0,1) += W1_NORMALIZATION / 3. * sums.w120[1];
+                acc_(1,0) += W1_NORMALIZATION / 3. * sums.w120[1];
+                acc_(1,1) += W1_NORMALIZATION / 3. * sums.w120[2];
+            }
+            if (w102) {
+                // normal (tensor) normal times length
+                mat_t &acc_ = w102->acc (l);
+                acc_(0,0) += W1_NORMALIZATION * sums.dd[2];
+                acc_(0,1) -= W1_NORMALIZATION * sums.dd[1];
+                acc_(1,0) -= W1_NORMALIZATION * sums.dd[1];
+                acc_(1,1) += W1_NORMALIZATION * sums.dd[0];
+            }
+            if (w211) {
+                mat_t &acc_ = w211->acc (l);
+                acc_(0,0) += W2_NORMALIZATION * sums.dd[0];
+                acc_(0,1) += W2_NORMALIZATION * sums.dd[1];
+                acc_(1,0) += W2_NORMALIZATION * sums.dd[1];
+                acc_(1,1) += W2_NORMALIZATION * sums.dd[2];
+            }
+        }
+        for (int j = i + n; j != k; ++j) {
+            load_frozen_edge_data (&e, b, j, j+1);
+            rest.add_edge (e);
+        }
+        i = k;
+    }
+    if (first != last && last == end) {
+        load_frozen_edge_data (&e, b, end-1, begin);
+        rest.add_edge (e);
+    }
+}
+
+
+//
+// sums of the functionals over domains
+//
+
+minkowski_sums_t::minkowski_sums_t () {
+    w000 = w100 = w200 = w220_mass = 0.;
+    w010.loadZero ();
+    w110.loadZero ();
+    w210.loadZero ();
+    w220_moment.loadZero ();
+    w020.loadZero ();
+    w120.loadZero ();
+    w102.loadZero ();
+    w220.loadZero ();
+    w211.loadZero ();
+}
+
+minkowski_sums_t &minkowski_sums_t::operator+= (const minkowski_sums_t &o) {
+    w000 += o.w000; w100 += o.w100; w200 += o.w200;
+    w010 += o.w010; w110 += o.w110; w210 += o.w210;
+    w020 += o.w020; w120 += o.w120; w102 += o.w102;
+    w220 += o.w220; w211 += o.w211;
+    w220_mass += o.w220_mass;
+    w220_moment += o.w220_moment;
+    return *this;
+}
+
+minkowski_sums_t &minkowski_sums_t::operator-= (const minkowski_sums_t &o) {
+    w000 -= o.w000; w100 -= o.w100; w200 -= o.w200;
+    w010 -= o.w010; w110 -= o.w110; w210 -= o.w210;
+    w020 -= o.w020; w120 -= o.w120; w102 -= o.w102;
+    w220 -= o.w220; w211 -= o.w211;
+    w220_mass -= o.w220_mass;
+    w220_moment -= o.w220_moment;
+    return *this;
+}
+
+// sum (x-r-d) (tensor) (x-r-d) from the sums of 1, x-r and
+// (x-r) (tensor) (x-r)
+static void translate_tensor (mat_t *m, const vec_t &moment, double mass,
+                              const vec_t &d) {
+    (*m)(0,0) += d[0]*d[0] * mass - 2. * d[0] * moment[0];
+    (*m)(0,1) += d[0]*d[1] * mass - d[0] * moment[1] - moment[0] * d[1];
+    (*m)(1,0) += d[1]*d[0] * mass - d[1] * moment[0] - moment[1] * d[0];
+    (*m)(1,1) += d[1]*d[1] * mass - 2. * d[1] * moment[1];
+}
+
+static void translate_vector (vec_t *v, double mass, const vec_t &d) {
+    (*v)[0] -= d[0] * mass;
+    (*v)[1] -= d[1] * mass;
+}
+
+void minkowski_sums_t::translate (const vec_t &d) {
+    // the tensors first, they need the old vectors
+    translate_tensor (&w020, w010, w000, d);
+    translate_tensor (&w120, w110, w100, d);
+    translate_tensor (&w220, w220_moment, w220_mass, d);
+    translate_vector (&w010, w000, d);
+    translate_vector (&w110, w100, d);
+    translate_vector (&w210, w200, d);
+    translate_vector (&w220_moment, w220_mass, d);
+}
+
+void minkowski_sums (std::vector <minkowski_sums_t> *dst, const Boundary &b,
+                     const Boundary &b_w0, int num_labels, const vec_t &ref,
+                     int num_threads) {
+    FusedMinkowskiFunctionals f, f_w0;
+    f_w0.w000 = create_w000 ();
+    f_w0.w010 = create_w010 ();
+    f_w0.w020 = create_w020 ();
+    f.w100 = create_w100 ();
+    f.w200 = create_w200 ();
+    f.w110 = create_w110 ();
+    f.w210 = create_w210 ();
+    f.w120 = create_w120 ();
+    f.w102 = create_w102 ();
+    f.w220 = create_w220 ();
+    f.w211 = create_w211 ();
+    AbstractMinkowskiFunctional *with_ref[] = { f_w0.w010, f_w0.w020,
+        f.w110, f.w210, f.w120, f.w220 };
+    for (int i = 0; i != 6; ++i)
+        with_ref[i]->global_ref_vertex (ref);
+    f.num_threads = f_w0.num_threads = num_threads;
+    f.add_boundary (FrozenBoundary (b));
+    f_w0.add_boundary (FrozenBoundary (b_w0));
+
+    dst->assign (num_labels, minkowski_sums_t ());
+    for (int l = 0; l != num_labels; ++l) {
+        minkowski_sums_t &s = (*dst)[l];
+        s.w000 = f_w0.w000->value (l);
+        s.w010 = f_w0.w010->value (l);
+        s.w020 = f_w0.w020->value (l);
+        s.w100 = f.w100->value (l);
+        s.w200 = f.w200->value (l);
+        s.w110 = f.w110->value (l);
+        s.w210 = f.w210->value (l);
+        s.w120 = f.w120->value (l);
+        s.w102 = f.w102->value (l);
+        s.w220 = f.w220->value (l);
+        s.w211 = f.w211->value (l);
+    }
+
+    // the weights of W220, half of each vertex to either edge
+    const double prefactor = .5 * W2_NORMALIZATION;
+    Boundary::contour_iterator cit;
+    Boundary::edge_iterator eit;
+    for (cit = b.contours_begin (); cit != b.contours_end (); ++cit)
+    for (eit = b.edges_begin (cit); eit != b.edges_end (cit); ++eit) {
+        int l = b.edge_label (eit);
+        if (l == Boundary::NO_LABEL)
+            continue;
+        assert (l >= 0 && l < num_labels);
+        minkowski_sums_t &s = (*dst)[l];
+        double infl0 = b.inflection_before_edge (eit);
+        double infl1 = b.inflection_after_edge (eit);
+        vec_t loc0 = b.edge_vertex0 (eit);
+        loc0 -= ref;
+        vec_t loc1 = b.edge_vertex1 (eit);
+        loc1 -= ref;
+        s.w220_mass += prefactor * (infl0 + infl1);
+        s.w220_moment += (prefactor * infl0) * loc0;
+        s.w220_moment += (prefactor * infl1) * loc1;
+    }
+
+    delete f_w0.w000; delete f_w0.w010; delete f_w0.w020;
+    delete f.w100; delete f.w200; delete f.w110; delete f.w210;
+    delete f.w120; delete f.w102; delete f.w220; delete f.w211;
+}
+
+void window_sums (std::vector <minkowski_sums_t> *dst,
+                  const std::vector <minkowski_sums_t> &cells,
+                  int nx, int ny, int wx, int wy, int sx, int sy) {
+    assert ((int)cells.size () == nx * ny);
+    assert (wx > 0 && wx <= nx && wy > 0 && wy <= ny && sx > 0 && sy > 0);
+    // prefix[j*(nx+1) + i] is the sum over the cells [0, i) x [0, j)
+    const int stride = nx + 1;
+    std::vector <minkowski_sums_t> prefix (stride * (ny + 1));
+    for (int j = 0; j != ny; ++j) {
+        minkowski_sums_t row;
+        for (int i = 0; i != nx; ++i) {
+            row += cells[j*nx + i];
+            minkowski_sums_t &p = prefix[(j+1)*stride + i+1];
+            p = prefix[j*stride + i+1];
+            p += row;
+        }
+    }
+    const int mx = (nx - wx) / sx + 1, my = (ny - wy) / sy + 1;
+    dst->resize (mx * my);
+    for (int j = 0; j != my; ++j)
+    for (int i = 0; i != mx; ++i) {
+        const int x0 = i * sx, x1 = x0 + wx;
+        const int y0 = j * sy, y1 = y0 + wy;
+        minkowski_sums_t &s = (*dst)[j*mx + i];
+        s = prefix[y1*stride + x1];
+        s -= prefix[y0*stride + x1];
+        s -= prefix[y1*stride + x0];
+        s += prefix[y0*stride + x0];
+    }
+}
+
+void coarser_domains (std::vector <minkowski_sums_t> *dst,
+                      const std::vector <minkowski_sums_t> &domains,
+                      int nx, int ny) {
+    assert ((int)domains.size () == nx * ny && nx % 2 == 0 && ny % 2 == 0);
+    const int mx = nx / 2;
+    dst->assign (mx * (ny / 2), minkowski_sums_t ());
+    for (int j = 0; j != ny; ++j)
+    for (int i = 0; i != nx; ++i)
+        (*dst)[(j/2)*mx + i/2] += domains[j*nx + i];
+}
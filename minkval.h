@@ -9,6 +9,14 @@
 
 extern double W0_NORMALIZATION, W1_NORMALIZATION, W2_NORMALIZATION;
 
+// the functionals which are plain sums over edges (W000, W100, W010,
+// W110, W020, W120, W102, W211) are evaluated with vector instructions
+// when the CPU supports them (currently AVX on x86).  the results differ
+// from the scalar code by rounding only.  set to false to force the
+// scalar code.
+extern bool USE_SIMD_KERNELS;
+bool simd_kernels_available ();
+
 class AbstractMinkowskiFunctional {
 public:
     typedef Boundary::edge_iterator edge_iterator;
@@ -48,7 +56,17 @@ public:
 
     const value_t &value (label_t) const;
 
+    // forget all accumulated values
+    void clear ();
+    // add the accumulated values of another functional, label by label
+    void add_values (const this_t &);
+    // move the value of each label l to label new_label[l], adding up
+    // values which end up on the same label.  the reference vertices are
+    // left alone, so this only makes sense if they are all the same.
+    void merge_labels (const std::vector <label_t> &new_label, int num_labels);
+
 protected:
+    friend class FusedMinkowskiFunctionals;
     value_t &acc (label_t);
     void reszacc (label_t);
     static void dump_accu (std::ostream &os, double);
@@ -73,6 +91,94 @@ typedef GenericMinkowskiFunctional <mat_t>  MatrixMinkowskiFunctional;
 
 void calculate_all_surface_integrals (const Boundary &b);
 
+// the values of all the functionals for a single label, about a point
+// of reference common to all labels.  the values of several labels
+// (e.g. of neighbouring domains) can be added up, and then moved to
+// another point of reference.
+// W220 gives half the weight of a vertex to each of its two edges, while
+// W200 and W210 give all of it to the edge before.  so W220 is moved with
+// w220_mass and w220_moment, which are W200 and W210 with the weights
+// split like in W220; the two only differ if a vertex with nonzero
+// inflection sits on a domain divider.
+struct minkowski_sums_t {
+    double w000, w100, w200;
+    vec_t w010, w110, w210;
+    mat_t w020, w120, w102, w220, w211;
+    double w220_mass;
+    vec_t w220_moment;
+
+    // all zero
+    minkowski_sums_t ();
+    minkowski_sums_t &operator+= (const minkowski_sums_t &);
+    minkowski_sums_t &operator-= (const minkowski_sums_t &);
+    // move the point of reference from r to r + d
+    void translate (const vec_t &d);
+};
+
+// evaluate several Minkowski functionals in a single sweep over a
+// Boundary.  the per-edge quantities (vertices, length, normal and
+// inflection angles) are computed once and shared by all functionals;
+// the formulas are the same as in the individual functionals.
+// functionals which are not needed are left NULL.
+class FusedMinkowskiFunctionals {
+public:
+    typedef Boundary::edge_iterator edge_iterator;
+
+    // everything the functionals need to know about a single edge
+    struct edge_data_t {
+        int label;
+        vec_t vert0, vert1;
+        double length;
+        // unit tangent and outward-pointing normal
+        vec_t tangent, normal;
+        // inflection angles at vert0 and vert1
+        double infl_before, infl_after;
+    };
+
+    FusedMinkowskiFunctionals ();
+
+    ScalarMinkowskiFunctional *w000, *w100, *w200;
+    VectorMinkowskiFunctional *w010, *w110, *w210;
+    MatrixMinkowskiFunctional *w020, *w120, *w102, *w220, *w211;
+
+    // number of threads used by add_boundary (const FrozenBoundary &).
+    // each thread sums up a contiguous range of edges into private
+    // copies of the functionals, which are added up in a fixed order
+    // afterwards; so the results are reproducible for a given number of
+    // threads, but differ from the serial results by rounding.
+    int num_threads;
+
+    // true if no functional is attached
+    bool empty () const;
+    // true if any attached functional needs the inflection angles
+    bool needs_inflections () const;
+    // true if any attached functional is a plain sum over edges
+    bool has_polygon_sums () const;
+
+    void add_contour (const Boundary &, edge_iterator begin, edge_iterator end);
+    void add_boundary (const Boundary &);
+    // same, streaming through the flat arrays of a FrozenBoundary
+    void add_contour (const FrozenBoundary &, int contour);
+    void add_boundary (const FrozenBoundary &);
+    // edges [first, last) of a contour
+    void add_edges (const FrozenBoundary &, int contour, int first, int last);
+    // edges [first, last) of the whole FrozenBoundary, which may span
+    // several contours
+    void add_edge_range (const FrozenBoundary &, int first, int last);
+    // update all the functionals with the contribution of one edge
+    void add_edge (const edge_data_t &);
+    // GenericMinkowskiFunctional::merge_labels for all functionals
+    void merge_labels (const std::vector <int> &new_label, int num_labels);
+    // add values which were summed up elsewhere to a label of all
+    // functionals.  the reference vertices are not looked at.
+    void add_sums (int label, const minkowski_sums_t &);
+
+private:
+    void add_edges_scalar_ (const FrozenBoundary &, int contour, int first, int last);
+    void add_polygon_sums_simd_ (const FrozenBoundary &, int contour, int first, int last);
+    void add_boundary_parallel_ (const FrozenBoundary &, int num_threads);
+};
+
 ScalarMinkowskiFunctional *create_w000 ();
 ScalarMinkowskiFunctional *create_w100 ();
 ScalarMinkowskiFunctional *create_w200 ();
@@ -85,6 +191,25 @@ MatrixMinkowskiFunctional *create_w102 ();
 MatrixMinkowskiFunctional *create_w220 ();
 MatrixMinkowskiFunctional *create_w211 ();
 
+// the minkowski_sums_t of labels [0, num_labels) of b, about the point of
+// reference ref.  W000, W010 and W020 are taken from b_w0, which is a
+// separate boundary in by_domain mode.
+void minkowski_sums (std::vector <minkowski_sums_t> *, const Boundary &b,
+                     const Boundary &b_w0, int num_labels, const vec_t &ref,
+                     int num_threads = 1);
+// sums over windows of wx x wy cells of a grid of nx x ny cells, which
+// are numbered like the domains of label_by_domain.  window (i, j) starts
+// at cell (i*sx, j*sy), and the windows are numbered like the cells.
+// each window is taken from a table of 2d prefix sums in constant time.
+void window_sums (std::vector <minkowski_sums_t> *,
+                  const std::vector <minkowski_sums_t> &cells,
+                  int nx, int ny, int wx, int wy, int sx, int sy);
+// the next coarser level of a quadtree over a grid of nx x ny domains
+// (both even), i.e. the sums over blocks of 2 x 2 domains.
+void coarser_domains (std::vector <minkowski_sums_t> *,
+                      const std::vector <minkowski_sums_t> &domains,
+                      int nx, int ny);
+
 
 //
 // inline implementation
@@ -94,6 +219,19 @@ inline AbstractMinkowskiFunctional::AbstractMinkowskiFunctional () {
     global_ref_vertex_ = vec_t (0., 0.);
 }
 
+inline bool FusedMinkowskiFunctionals::empty () const {
+    return !(w000 || w100 || w200 || w010 || w110 || w210 ||
+             w020 || w120 || w102 || w220 || w211);
+}
+
+inline bool FusedMinkowskiFunctionals::needs_inflections () const {
+    return w200 || w210 || w220;
+}
+
+inline bool FusedMinkowskiFunctionals::has_polygon_sums () const {
+    return w000 || w100 || w010 || w110 || w020 || w120 || w102 || w211;
+}
+
 // allocate new labels (i.e. reference vertices for more labels)
 inline void AbstractMinkowskiFunctional::reszref (label_t l) const {
     if (l < MAX_LABELS) {
@@ -157,6 +295,28 @@ inline const std::string &GenericMinkowskiFunctional <VALUE_TYPE>::name () const
     return my_name;
 }
 
+template <typename VALUE_TYPE>
+void GenericMinkowskiFunctional<VALUE_TYPE>::clear () {
+    my_acc.clear ();
+}
+
+template <typename VALUE_TYPE>
+void GenericMinkowskiFunctional<VALUE_TYPE>::add_values (const this_t &other) {
+    for (int l = 0; l != (int)other.my_acc.size (); ++l)
+        acc (l) += other.my_acc[l];
+}
+
+template <typename VALUE_TYPE>
+void GenericMinkowskiFunctional<VALUE_TYPE>::merge_labels (
+        const std::vector <label_t> &new_label, int num_labels) {
+    std::vector <value_t> old_acc;
+    old_acc.swap (my_acc);
+    if (num_labels)
+        reszacc (num_labels - 1);
+    for (int l = 0; l != (int)old_acc.size (); ++l)
+        acc (new_label.at (l)) += old_acc[l];
+}
+
 // allocate new labels (i.e. accumulators for more labels)
 template <typename VALUE_TYPE>
 void GenericMinkowskiFunctional<VALUE_TYPE>::reszacc (label_t l) {
@@ -4,13 +4,16 @@
 #include "util.h"
 #include <fstream>
 #include <stdexcept>
+#include <string.h>
+#include <ctype.h>
+#include <pthread.h>
 using namespace std;
 
 static void format_error (const string &msg) {
     throw std::runtime_error (msg);
 }
 
-static long read_header (Pixmap *p, string *magic, std::string *comment, istream &is) {
+static long read_header (int *w, int *h, string *magic, std::string *comment, istream &is) {
     is >> *magic;
     if (*magic != "P1" && *magic != "P2" && *magic != "P4" &&
             *magic != "P5")
@@ -22,96 +25,248 @@ static long read_header (Pixmap *p, string *magic, std::string *comment, istream
         *comment += tmp;
         *comment += " ";
     }
-    int w, h;
     long max_value = 1;
-    is >> w >> h;
+    is >> *w >> *h;
     if (*magic == "P2" || *magic == "P5")
         is >> max_value;
     is >> ws;
-    // allocate pixmap
-    if (w <= 0 || h <= 0)
+    if (*w <= 0 || *h <= 0 || max_value <= 0 || max_value > 65535)
         format_error ("header damaged");
-    p->resize (w, h);
     return max_value;
 }
 
-void load_pgm (Pixmap *p, const string &filename) {
-    assert (p);
-    ifstream is (filename.c_str ());
-    string magic, comment;
-    if (!is)
-        throw std::runtime_error ("Cannot open \"" + filename + "\"");
-    is.exceptions (ios::failbit | ios::badbit);
-    long max_value = read_header (p, &magic, &comment, is);
-    double nrml = 1. / max_value;
-
-    if (magic == "P2") {   // PGM ASCII
-        for (int j = 0; j != p->size2 (); ++j)
-        for (int i = 0; i != p->size1 (); ++i) {
-            long tmp;
-            is >> tmp;
-            (*p)(i,j) = Pixmap::val_t (tmp * nrml);
+static bool is_space (char c) {
+    return c == ' ' || c == '\n' || c == '\t' || c == '\r' ||
+           c == '\v' || c == '\f';
+}
+
+// the file should be empty after the pixels
+static void check_trailing_data (const MappedFile &file, long end,
+                                 const string &filename) {
+    for (long i = end; i != file.size (); ++i)
+        if (!is_space (file.data ()[i]))
+            format_error ("trailing data in \"" + filename + "\"");
+}
+
+// fill p from the raster of a binary file, a row at a time
+static void load_raster (Pixmap *p, const string &filename, long offset,
+                         const string &magic, long max_value) {
+    const int w = p->size1 (), h = p->size2 ();
+    const int bytes_per_pixel = max_value < 256 ? 1 : 2;
+    const long row_bytes = magic == "P4" ? (w + 7) / 8 : long (w) * bytes_per_pixel;
+    MappedFile file (filename);
+    if (file.size () < offset + row_bytes * h)
+        format_error ("\"" + filename + "\" is truncated");
+    check_trailing_data (file, offset + row_bytes * h, filename);
+    const unsigned char *raster = (const unsigned char *)file.data () + offset;
+    unsigned int max_found = 0;
+    for (int j = 0; j != h; ++j) {
+        const unsigned char *src = raster + j * row_bytes;
+        if (magic == "P4") {
+            // PBM: black=1, white=0
+            unsigned char *dst = (unsigned char *)p->raw_row (j);
+            for (int i = 0; i != row_bytes; ++i)
+                dst[i] = (unsigned char)~src[i];
+        } else if (bytes_per_pixel == 1) {
+            unsigned char m = 0;
+            for (int i = 0; i != w; ++i)
+                m = std::max (m, src[i]);
+            max_found = std::max (max_found, (unsigned int)m);
+            memcpy (p->raw_row (j), src, w);
+        } else {
+            // big endian
+            unsigned short *dst = (unsigned short *)p->raw_row (j);
+            unsigned short m = 0;
+            for (int i = 0; i != w; ++i) {
+                dst[i] = (unsigned short)(src[2*i] << 8 | src[2*i+1]);
+                m = std::max (m, dst[i]);
+            }
+            max_found = std::max (max_found, (unsigned int)m);
         }
     }
-    else if (magic == "P1") // PBM ASCII
-    {
-        for (int j = 0; j != p->size2 (); ++j)
-        for (int i = 0; i != p->size1 (); ++i) {
-            int tmp;
-            is >> tmp;
-            (*p)(i,j) = Pixmap::val_t (1-tmp); // PBM: black=1, white=0
+    if (long (max_found) > max_value)
+        format_error ("pixel value out of range");
+}
+
+// a piece of the pixels of an ASCII file, which begins and ends
+// between two numbers (or PBM digits)
+struct ascii_chunk_t {
+    const char *begin, *end;
+    bool bits;
+    long max_value;
+    std::vector <unsigned short> values;
+    std::string error;
+};
+
+static void scan_ascii (ascii_chunk_t *c) {
+    const char *s = c->begin, *e = c->end;
+    while (s != e) {
+        if (is_space (*s)) {
+            ++s;
+            continue;
         }
-    }
-    else if (magic == "P4") // PBM binary
-    {
-        for (int j = 0; j != p->size2 (); ++j)
-        for (int i = 0; i != p->size1 (); ) {
-            char tmp;
-            is.get(tmp); 
-            // 1 byte=8 pixel, split accordingly
-            unsigned char mask = 0x80;
-            while (mask) {
-                // extract bit
-                int value = !! (static_cast <unsigned char> (tmp) & mask);
-                (*p)(i,j) = Pixmap::val_t (1-value); // black=1, white=0
-                if (++i == p->size1())
-                    break;
-                mask >>= 1;
+        if (c->bits) {
+            // PBM digits need not be separated
+            if (*s != '0' && *s != '1') {
+                c->error = "pixel data damaged";
+                return;
             }
+            c->values.push_back ((unsigned short)(*s++ - '0'));
+            continue;
         }
-    }
-    else if (magic == "P5") // PGM binary
-    {
-        // <256 == 1byte/pix
-        if (max_value<256)
-            for (int j = 0; j != p->size2 (); ++j)
-            for (int i = 0; i != p->size1 (); ++i) {
-                char tmp;
-                is.get(tmp);
-                const long value=(unsigned char)(tmp);
-                (*p)(i,j) = Pixmap::val_t (value * nrml);
+        long value = 0;
+        const char *digits = s;
+        for (; s != e && *s >= '0' && *s <= '9'; ++s) {
+            value = 10 * value + (*s - '0');
+            if (value > c->max_value) {
+                c->error = "pixel value out of range";
+                return;
             }
-        // >255 == 2byte/pix
-        else
-            for (int j = 0; j != p->size2 (); ++j)
-            for (int i = 0; i != p->size1 (); ++i) {
-                char tmp1, tmp2;
-                is.get(tmp1);
-                is.get(tmp2);
-                long tmp = long (static_cast <unsigned char> (tmp1)) << 8 |
-                           long (static_cast <unsigned char> (tmp2));
-                (*p)(i,j) = Pixmap::val_t (tmp * nrml);
+        }
+        if (s == digits || (s != e && !is_space (*s))) {
+            c->error = "pixel data damaged";
+            return;
+        }
+        c->values.push_back ((unsigned short)value);
+    }
+}
+
+static void *scan_ascii_thread (void *c) {
+    scan_ascii ((ascii_chunk_t *)c);
+    return 0;
+}
+
+// read the pixels of a P1 or P2 file, which start at offset.  the file
+// is cut into num_threads chunks at white space, which are parsed in
+// parallel.
+static void load_ascii (Pixmap *p, const string &filename, long offset,
+                        const string &magic, long max_value, int num_threads) {
+    MappedFile file (filename);
+    const char *begin = file.data () + offset, *end = file.data () + file.size ();
+    num_threads = std::max (1, std::min (num_threads, int ((end - begin) >> 16)));
+    std::vector <ascii_chunk_t> chunks (num_threads);
+    for (int t = 0; t != num_threads; ++t) {
+        ascii_chunk_t &c = chunks[t];
+        c.begin = t ? chunks[t-1].end : begin;
+        c.end = t+1 == num_threads ? end
+              : std::max (c.begin, begin + (end - begin) / num_threads * (t+1));
+        while (c.end != end && !is_space (*c.end))
+            ++c.end;
+        c.bits = magic == "P1";
+        c.max_value = max_value;
+    }
+    std::vector <pthread_t> threads (num_threads);
+    for (int t = 1; t < num_threads; ++t)
+        if (pthread_create (&threads[t], 0, scan_ascii_thread, &chunks[t]))
+            die ("Unable to start thread");
+    scan_ascii (&chunks[0]);
+    for (int t = 1; t < num_threads; ++t)
+        pthread_join (threads[t], 0);
+
+    // the first error in the file wins
+    const long num_pixels = long (p->size1 ()) * p->size2 ();
+    long n = 0;
+    for (int t = 0; t != num_threads; ++t) {
+        if (!chunks[t].error.empty () && n + (long)chunks[t].values.size () < num_pixels)
+            format_error (chunks[t].error);
+        n += chunks[t].values.size ();
+        if (n > num_pixels || !chunks[t].error.empty ())
+            format_error ("trailing data in \"" + filename + "\"");
+    }
+    if (n < num_pixels)
+        format_error ("\"" + filename + "\" is truncated");
+
+    const bool bits = magic == "P1";
+    int i = 0, j = 0;
+    for (int t = 0; t != num_threads && j != p->size2 (); ++t) {
+        const std::vector <unsigned short> &values = chunks[t].values;
+        for (size_t k = 0; k != values.size (); ++k) {
+            // PBM: black=1, white=0
+            p->set_raw (i, j, bits ? 1 - values[k] : values[k]);
+            if (++i == p->size1 ()) {
+                i = 0;
+                ++j;
             }
+        }
     }
+}
+
+void load_pgm (Pixmap *p, const string &filename, int num_threads) {
+    assert (p);
+    ifstream is (filename.c_str ());
+    string magic, comment;
+    if (!is)
+        throw std::runtime_error ("Cannot open \"" + filename + "\"");
+    is.exceptions (ios::failbit | ios::badbit);
+    int w, h;
+    long max_value = read_header (&w, &h, &magic, &comment, is);
+    // allocate pixmap.  the raw values are stored, and scaled by
+    // 1/max_value only when they are read.
+    p->resize_raw (w, h, max_value);
+
+    if (magic == "P1" || magic == "P2") // ASCII
+        load_ascii (p, filename, long (is.tellg ()), magic, max_value,
+                    num_threads);
+    else if (magic == "P4" || magic == "P5") // binary
+        load_raster (p, filename, long (is.tellg ()), magic, max_value);
     else
         format_error ("magic incorrect");
+}
 
-    // file should be empty now
-    is.exceptions (ios::badbit); // Clear eofbit before reading beyond limit
-    is >> ws;
-    is.get (); // try to read something
-    if (is)
-        format_error ("trailing data in \'" + filename ="\"");
-    else
-        return; // yup, it's empty
+PgmRowReader::PgmRowReader (const string &filename)
+    : invert (false), my_is (filename.c_str (), ios::in | ios::binary) {
+    string magic, comment;
+    if (!my_is)
+        throw std::runtime_error ("Cannot open \"" + filename + "\"");
+    my_is.exceptions (ios::failbit | ios::badbit);
+    my_max_value = read_header (&my_xdim, &my_ydim, &magic, &comment, my_is);
+    if (magic == "P4") {
+        my_bits = 1;
+        my_row_bytes = (my_xdim + 7) / 8;
+    } else if (magic == "P5") {
+        my_bits = my_max_value < 256 ? 8 : 16;
+        my_row_bytes = my_xdim * (my_bits / 8);
+    } else {
+        format_error ("\"" + filename + "\": only binary PGM (P5) and PBM (P4) "
+                      "files can be read row by row");
+    }
+    my_data_start = my_is.tellg ();
+    my_next_row = 0;
+    my_buffer.resize (my_row_bytes);
+}
+
+int PgmRowReader::size1 () const {
+    return my_xdim;
+}
+
+int PgmRowReader::size2 () const {
+    return my_ydim;
+}
+
+void PgmRowReader::read_row (int j, Pixmap::val_t *row) {
+    assert (j >= 0 && j < my_ydim);
+    if (j != my_next_row)
+        my_is.seekg (my_data_start + std::streamoff (j) * my_row_bytes);
+    my_is.read ((char *)&my_buffer[0], my_row_bytes);
+    my_next_row = j+1;
+    const unsigned char *p = &my_buffer[0];
+    // integer values are inverted on their own scale, like invert
+    // (Pixmap *) does
+    const long off = invert ? my_max_value : 0;
+    const long sign = invert ? -1 : 1;
+    const double nrml = 1. / my_max_value;
+    if (my_bits == 1) {
+        for (int i = 0; i != my_xdim; ++i) {
+            int value = !! (p[i/8] & (0x80 >> (i%8)));
+            row[i] = Pixmap::val_t (off + sign * (1-value)); // black=1, white=0
+        }
+    } else if (my_bits == 8) {
+        for (int i = 0; i != my_xdim; ++i)
+            row[i] = Pixmap::val_t ((off + sign * long (p[i])) * nrml);
+    } else {
+        for (int i = 0; i != my_xdim; ++i) {
+            long tmp = long (p[2*i]) << 8 | long (p[2*i+1]);
+            row[i] = Pixmap::val_t ((off + sign * tmp) * nrml);
+        }
+    }
 }
@@ -3,10 +3,18 @@
 
 #include "util.h"
 #include <fstream>
+#include <iterator>
 #include <stdexcept>
 #include <limits>
 #include <stdarg.h>
 #include <stdio.h>
+#include <stdlib.h>
+#include <errno.h>
+#include <limits.h>
+#include <string.h>
+#include <pthread.h>
+#include <locale.h>
+#include <sys/stat.h>
 typedef std::string string;
 
 static no_return void format_error (const string &message, ...) {
@@ -17,77 +25,208 @@ static no_return void format_error (const string &message, ...) {
     throw std::runtime_error (buffer);
 }
 
+// the file is read into memory in one go, and parsed by hand.  these
+// work like the corresponding stream operations on a position in the
+// NUL terminated contents.
+namespace parse {
+    // isspace and isdigit independant of locale
+    static bool is_space (int c) {
+        return c == ' ' || c == '\n' || c == '\t' || c == '\r' ||
+               c == '\v' || c == '\f';
+    }
+
+    static bool is_digit (int c) {
+        return c >= '0' && c <= '9';
+    }
+
+    // like is.peek (), EOF at the end
+    static int peek (const char *s) {
+        return *s ? (unsigned char)*s : EOF;
+    }
+
+    // like is.get ()
+    static int get (const char **s) {
+        int ret = peek (*s);
+        if (ret != EOF)
+            ++*s;
+        return ret;
+    }
+
+    // like is >> std::ws
+    static void skip_ws (const char **s) {
+        while (is_space (**s))
+            ++*s;
+    }
+
+    static void ignore_rest_of_line (const char **s) {
+        const char *nl = strchr (*s, '\n');
+        *s = nl ? nl+1 : *s + strlen (*s);
+    }
+
+    // like is >> i, which skips white space
+    static int read_int (const char **s) {
+        char *end;
+        errno = 0;
+        long ret = strtol (*s, &end, 10);
+        if (end == *s || errno || ret > INT_MAX || ret < INT_MIN)
+            format_error ("format error in POLY file: expected a number, got %.20s", *s);
+        *s = end;
+        return int (ret);
+    }
+
+    // the end of the number at s, in the form is >> d takes it: an
+    // optional sign, digits with an optional decimal point, and an
+    // optional exponent.  s itself if there is none.
+    static const char *scan_double (const char *s) {
+        const char *p = s;
+        if (*p == '+' || *p == '-')
+            ++p;
+        const char *mantissa = p;
+        while (is_digit (*p))
+            ++p;
+        int digits = int (p - mantissa);
+        if (*p == '.')
+            for (++p; is_digit (*p); ++p)
+                ++digits;
+        if (!digits)
+            return s;
+        if (*p == 'e' || *p == 'E') {
+            const char *q = p+1;
+            if (*q == '+' || *q == '-')
+                ++q;
+            if (is_digit (*q)) {
+                while (is_digit (*q))
+                    ++q;
+                p = q;
+            }
+        }
+        return p;
+    }
+
+    // like is >> d, which skips white space.  strtod alone would also
+    // take inf, nan and hexadecimal numbers, and expect the decimal
+    // point of LC_NUMERIC; so it only gets a copy of the number, with
+    // the decimal point of the locale.
+    static double read_double (const char **s) {
+        skip_ws (s);
+        const char *end = scan_double (*s);
+        if (end == *s)
+            format_error ("format error in POLY file: expected a number, got %.20s", *s);
+        const char *point = localeconv ()->decimal_point;
+        const size_t point_len = strlen (point);
+        char buf[128];
+        size_t n = 0;
+        for (const char *p = *s; p != end; ++p) {
+            if (n + point_len + 1 >= sizeof (buf))
+                format_error ("format error in POLY file: number too long: %.20s", *s);
+            if (*p == '.') {
+                memcpy (buf + n, point, point_len);
+                n += point_len;
+            } else {
+                buf[n++] = *p;
+            }
+        }
+        buf[n] = '\0';
+        *s = end;
+        return strtod (buf, 0);
+    }
+
+    // a vertex record.  the rest of the line (i.e. attributes) is
+    // ignored for now, as is the z coordinate.
+    static void read_vertex (const char **s, int *number, double *x, double *y) {
+        *number = read_int (s);
+
+        // vertex number is terminated by colon
+        skip_ws (s);
+        int colon;
+        if ((colon = get (s)) != ':')
+            format_error ("expected colon, got %c", colon);
+
+        // coords
+        *x = read_double (s);
+        *y = read_double (s);
+        read_double (s);
+
+        ignore_rest_of_line (s);
+    }
+}
+
+// a piece of the POINTS section, starting at the beginning of a line,
+// which is parsed on its own thread
+struct points_chunk_t {
+    const char *begin, *end;
+    std::vector <int> number;
+    std::vector <double> x, y;
+    std::string error;
+};
+
+static void *parse_points_thread (void *c_) {
+    points_chunk_t *c = (points_chunk_t *)c_;
+    const char *s = c->begin;
+    try {
+        while (s < c->end) {
+            int number;
+            double x, y;
+            parse::read_vertex (&s, &number, &x, &y);
+            c->number.push_back (number);
+            c->x.push_back (x);
+            c->y.push_back (y);
+        }
+    } catch (std::runtime_error &e) {
+        c->error = e.what ();
+    }
+    return 0;
+}
+
 // object keeping the state during the process of reading a POLY file
 class PolyFileReader {
 public:
-    std::ifstream is;
+    std::vector <char> contents;
+    const char *s;
     Boundary *b;
     // mapping POLY vertex indices -> Boundary vertex indices
     std::vector <int> vertex_map;
 
-    // isdigit independant of locale
-    static bool is_digit (int c) {
-        switch (c) {
-        case '0':
-        case '1':
-        case '2':
-        case '3':
-        case '4':
-        case '5':
-        case '6':
-        case '7':
-        case '8':
-        case '9':
-            return true;
-        default:
-            return false;
-        }
-    }
-
     PolyFileReader (Boundary *b_, const string &polyfilename)
-        : is (polyfilename.c_str ()),
-          b (b_)
+        : b (b_)
     {
+        std::ifstream is (polyfilename.c_str (), std::ios::in | std::ios::binary);
         if (!is) {
             throw std::runtime_error ("Cannot open \"" +
                 polyfilename + "\"");
         }
-        is.exceptions (std::ios::failbit | std::ios::badbit);
-        vertex_map.reserve (1000);
+        is.exceptions (std::ios::badbit);
+        struct stat st;
+        if (stat (polyfilename.c_str (), &st) == 0 && S_ISREG (st.st_mode)) {
+            // in one go into a buffer of the right size
+            contents.resize (size_t (st.st_size) + 1);
+            is.read (&contents[0], st.st_size);
+            contents.resize (size_t (is.gcount ()) + 1);
+            contents.back () = '\0';
+        } else {
+            // pipes work as well
+            contents.assign (std::istreambuf_iterator <char> (is),
+                             std::istreambuf_iterator <char> ());
+            contents.push_back ('\0');
+        }
+        s = &contents[0];
+    }
+
+    int peek () const {
+        return parse::peek (s);
     }
 
     void extract_header (const string &tag) {
-        std::string tmp;
-        std::getline (is, tmp);
+        const char *nl = strchr (s, '\n');
+        string tmp (s, nl ? nl : s + strlen (s));
+        parse::ignore_rest_of_line (&s);
         if (tmp != tag) {
             format_error ("format error in POLY file: expected %s, got %s",
                 tag.c_str (), tmp.c_str ());
         }
     }
 
-    void ignore_rest_of_line () {
-        std::streamsize mx = std::numeric_limits <std::streamsize>::max ();
-        is.ignore (mx, '\n');
-    }
-
-    void read_vertex () {
-        int number;
-        is >> number;
-
-        // vertex number is terminated by colon
-        is >> std::ws;
-        int colon;
-        if ((colon = is.get ()) != ':')
-            format_error ("expected colon, got %c", colon);
-
-        // coords
-        double x, y, z;
-        is >> x >> y >> z;
-
-        // rest of record (i.e. attributes) is ignored for now
-        ignore_rest_of_line ();
-
-        // z coordinate is ignored
+    void add_vertex (int number, double x, double y) {
         int vert_id = b->insert_vertex (vec_t (x, y));
 
         // saved for later reference
@@ -97,6 +236,55 @@ public:
         vertex_map[number] = vert_id;
     }
 
+    void read_vertex () {
+        int number;
+        double x, y;
+        parse::read_vertex (&s, &number, &x, &y);
+        add_vertex (number, x, y);
+    }
+
+    // the whole POINTS section, cut into num_threads pieces at line
+    // boundaries.  every vertex has to be on a line of its own.
+    void read_points (int num_threads) {
+        const char *begin = s, *end = s;
+        long num_lines = 0;
+        while (parse::is_digit (parse::peek (end))) {
+            parse::ignore_rest_of_line (&end);
+            ++num_lines;
+        }
+        num_threads = (int)std::max (1L, std::min (long (num_threads), num_lines));
+        std::vector <points_chunk_t> chunks (num_threads);
+        for (int t = 0; t != num_threads; ++t) {
+            points_chunk_t &c = chunks[t];
+            c.begin = t ? chunks[t-1].end : begin;
+            c.end = t+1 == num_threads ? end
+                  : std::max (c.begin, begin + (end - begin) / num_threads * (t+1));
+            if (c.end != end && c.end != begin && c.end[-1] != '\n')
+                parse::ignore_rest_of_line (&c.end);
+        }
+        std::vector <pthread_t> threads (num_threads);
+        for (int t = 1; t < num_threads; ++t)
+            if (pthread_create (&threads[t], 0, parse_points_thread, &chunks[t]))
+                die ("Unable to start thread");
+        parse_points_thread (&chunks[0]);
+        for (int t = 1; t < num_threads; ++t)
+            pthread_join (threads[t], 0);
+
+        // the first error in the file wins
+        for (int t = 0; t != num_threads; ++t)
+            if (!chunks[t].error.empty ())
+                throw std::runtime_error (chunks[t].error);
+        int max_number = -1;
+        for (int t = 0; t != num_threads; ++t)
+        for (size_t i = 0; i != chunks[t].number.size (); ++i)
+            max_number = std::max (max_number, chunks[t].number[i]);
+        vertex_map.reserve (max_number + 1);
+        for (int t = 0; t != num_threads; ++t)
+        for (size_t i = 0; i != chunks[t].number.size (); ++i)
+            add_vertex (chunks[t].number[i], chunks[t].x[i], chunks[t].y[i]);
+        s = end;
+    }
+
     int lookup_vertex (int v_id) {
         if ((int)vertex_map.size () > v_id && v_id >= 0) {
             int ret = vertex_map[v_id];
@@ -108,22 +296,20 @@ public:
     }
 
     void read_poly () {
-        int number;
-        is >> number;
+        int number = parse::read_int (&s);
 
         // poly number is terminated by colon
-        is >> std::ws;
+        parse::skip_ws (&s);
         int colon;
-        if ((colon = is.get ()) != ':')
+        if ((colon = parse::get (&s)) != ':')
             format_error ("PolyFileReader::read_poly: expected colon, got %c", colon);
 
         // first two vertices
-        int initial_vertex;
-        is >> initial_vertex;
+        int initial_vertex = parse::read_int (&s);
         // translate POLY vertices into Boundary vertices
         initial_vertex = lookup_vertex (initial_vertex);
-        int prev_vertex;
-        is >> prev_vertex >> std::ws;
+        int prev_vertex = parse::read_int (&s);
+        parse::skip_ws (&s);
         prev_vertex = lookup_vertex (prev_vertex);
 
         int initial_edge = b->insert_edge (Boundary::INVALID_EDGE,
@@ -131,9 +317,9 @@ public:
                                     Boundary::INVALID_EDGE);
 
         int prev_edge = initial_edge;
-        while (is_digit (is.peek ())) {
-            int vertex;
-            is >> vertex >> std::ws;
+        while (parse::is_digit (peek ())) {
+            int vertex = parse::read_int (&s);
+            parse::skip_ws (&s);
             // translate POLY vertices into Boundary vertices
             vertex = lookup_vertex (vertex);
 
@@ -143,47 +329,37 @@ public:
             prev_edge = edge;
         }
 
-        is >> std::ws;
-        int closed_indic = is.peek ();
+        parse::skip_ws (&s);
+        int closed_indic = peek ();
         if (closed_indic == '<') {
             // extract '<' character
-            is.get ();
+            parse::get (&s);
             // close contour
             b->insert_edge (prev_edge, prev_vertex, initial_vertex, initial_edge);
         } else {
             std::cerr << "WARNING: non-closed contour " << number << ". this is probably not what you want.\n";
         }
 
-        ignore_rest_of_line ();
+        parse::ignore_rest_of_line (&s);
     }
 };
 
-void load_poly (Boundary *b, const string &polyfilename) {
+void load_poly (Boundary *b, const string &polyfilename, int num_threads) {
     PolyFileReader r (b, polyfilename);
     r.extract_header ("POINTS");
-    while (int p = r.is.peek ()) {
-        if (r.is_digit (p)) {
+    if (num_threads > 1) {
+        r.read_points (num_threads);
+    } else {
+        while (parse::is_digit (r.peek ())) {
             // incoming number
             r.read_vertex ();
-        } else {
-            // something else
-            goto no_more_points;
         }
     }
-no_more_points:
     r.extract_header ("POLYS");
-    while (int p = r.is.peek ()) {
-        if (r.is_digit (p)) {
-            // incoming number
-            r.read_poly ();
-        } else {
-            // something else
-            goto no_more_polys;
-        }
+    while (parse::is_digit (r.peek ())) {
+        // incoming number
+        r.read_poly ();
     }
-no_more_polys:
     r.extract_header ("END");
     // rest of file is ignored.
-    r.is.close ();
 }
-
@@ -0,0 +1 @@
+plot "circle_normalization_breidenbach.out/contours.out" w lp
@@ -0,0 +1 @@
+plot "circle_normalization_new.out/contours.out" w lp
@@ -0,0 +1,5 @@
+unset key
+plot \
+	"circle_normalization_new.out/labels.out" index 0 w lp lt 1 pt 1\
+	,\
+	(1./0)
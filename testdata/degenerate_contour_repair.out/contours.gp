@@ -0,0 +1 @@
+plot "degenerate_contour_repair.out/contours.out" w lp
@@ -0,0 +1,5 @@
+unset key
+plot \
+	"degenerate_contour_repair.out/nu0labels.out" index 0 w lp lt 1 pt 1\
+	,\
+	(1./0)
@@ -0,0 +1 @@
+plot "dummy.out/contours.out" w lp
@@ -0,0 +1,405 @@
+// vim: et:sw=4:ts=4
+// compare the fused evaluation of the Minkowski functionals
+// against the individual functionals.
+
+#include <iostream>
+#include <sstream>
+#include <stdexcept>
+#include <stdio.h>
+#include "../util.h"
+#include "../minkval.h"
+
+static bool failed = false;
+
+static double difference (double a, double b) {
+    return fabs (a - b);
+}
+
+static double difference (const vec_t &a, const vec_t &b) {
+    return std::max (fabs (a[0] - b[0]), fabs (a[1] - b[1]));
+}
+
+static double difference (const mat_t &a, const mat_t &b) {
+    return std::max (
+        std::max (fabs (a(0,0) - b(0,0)), fabs (a(0,1) - b(0,1))),
+        std::max (fabs (a(1,0) - b(1,0)), fabs (a(1,1) - b(1,1))));
+}
+
+static double magnitude (double a) {
+    return fabs (a);
+}
+
+static double magnitude (const vec_t &a) {
+    return difference (a, vec_t (0., 0.));
+}
+
+static double magnitude (const mat_t &a) {
+    mat_t zero;
+    zero(0,0) = zero(0,1) = zero(1,0) = zero(1,1) = 0.;
+    return difference (a, zero);
+}
+
+// tolerance is relative to the magnitude of the reference value
+template <typename FUNCTIONAL>
+static void compare (const std::string &testname, int num_labels,
+                     const FUNCTIONAL &ref, const FUNCTIONAL &other,
+                     double tolerance) {
+    for (int l = 0; l != num_labels; ++l) {
+        double d = difference (ref.value (l), other.value (l));
+        if (! (d <= tolerance * (1. + magnitude (ref.value (l))))) {
+            std::cerr << testname << ": " << ref.name () << " mismatch for label "
+                      << l << " (difference " << d << ")\n";
+            failed = true;
+            return;
+        }
+    }
+}
+
+// a complete set of functionals, created in the order of all_funcs in driver.cpp
+struct FunctionalSet {
+    ScalarMinkowskiFunctional *w000, *w100, *w200;
+    VectorMinkowskiFunctional *w010, *w110, *w210;
+    MatrixMinkowskiFunctional *w020, *w120, *w102, *w220, *w211;
+
+    FunctionalSet ()
+        : w000 (create_w000 ()), w100 (create_w100 ()), w200 (create_w200 ()),
+          w010 (create_w010 ()), w110 (create_w110 ()), w210 (create_w210 ()),
+          w020 (create_w020 ()), w120 (create_w120 ()), w102 (create_w102 ()),
+          w220 (create_w220 ()), w211 (create_w211 ()) {
+    }
+
+    ~FunctionalSet () {
+        for (int i = 0; i != 11; ++i)
+            delete all ()[i];
+    }
+
+    AbstractMinkowskiFunctional **all () {
+        all_[0] = w000; all_[1] = w100; all_[2] = w200;
+        all_[3] = w010; all_[4] = w110; all_[5] = w210;
+        all_[6] = w020; all_[7] = w120; all_[8] = w102;
+        all_[9] = w220; all_[10] = w211;
+        return all_;
+    }
+
+    // use a different reference vertex for each label
+    void set_ref_vertices (int num_labels) {
+        for (int i = 0; i != 11; ++i)
+        for (int l = 0; l != num_labels; ++l)
+            all ()[i]->ref_vertex (l, vec_t (.5 * l, 1. - .25 * l));
+    }
+
+    void attach_to (FusedMinkowskiFunctionals *f) {
+        f->w000 = w000; f->w100 = w100; f->w200 = w200;
+        f->w010 = w010; f->w110 = w110; f->w210 = w210;
+        f->w020 = w020; f->w120 = w120; f->w102 = w102;
+        f->w220 = w220; f->w211 = w211;
+    }
+
+    void compare_to (const std::string &testname, int num_labels,
+                     const FunctionalSet &other, double tolerance = 1e-10) const {
+        compare (testname, num_labels, *w000, *other.w000, tolerance);
+        compare (testname, num_labels, *w100, *other.w100, tolerance);
+        compare (testname, num_labels, *w200, *other.w200, tolerance);
+        compare (testname, num_labels, *w010, *other.w010, tolerance);
+        compare (testname, num_labels, *w110, *other.w110, tolerance);
+        compare (testname, num_labels, *w210, *other.w210, tolerance);
+        compare (testname, num_labels, *w020, *other.w020, tolerance);
+        compare (testname, num_labels, *w120, *other.w120, tolerance);
+        compare (testname, num_labels, *w102, *other.w102, tolerance);
+        compare (testname, num_labels, *w220, *other.w220, tolerance);
+        compare (testname, num_labels, *w211, *other.w211, tolerance);
+    }
+
+private:
+    FunctionalSet (const FunctionalSet &);
+    AbstractMinkowskiFunctional *all_[11];
+};
+
+static void test_boundary (const std::string &testname, const Boundary &b,
+                           int num_labels) {
+    FunctionalSet reference;
+    reference.set_ref_vertices (num_labels);
+    for (int i = 0; i != 11; ++i) {
+        Boundary::contour_iterator cit;
+        for (cit = b.contours_begin (); cit != b.contours_end (); ++cit)
+            reference.all ()[i]->add_contour (b, b.edges_begin (cit), b.edges_end (cit));
+    }
+
+    FunctionalSet fused;
+    fused.set_ref_vertices (num_labels);
+    FusedMinkowskiFunctionals f;
+    fused.attach_to (&f);
+    f.add_boundary (b);
+    reference.compare_to (testname + " (fused)", num_labels, fused);
+
+    Boundary cached = b;
+    cached.cache_geometry ();
+    FunctionalSet fused_cached;
+    fused_cached.set_ref_vertices (num_labels);
+    FusedMinkowskiFunctionals fc;
+    fused_cached.attach_to (&fc);
+    fc.add_boundary (cached);
+    reference.compare_to (testname + " (cached)", num_labels, fused_cached);
+
+    // the frozen evaluation with and without the vector kernels
+    for (int simd = 0; simd != 2; ++simd) {
+        if (simd && !simd_kernels_available ())
+            break;
+        USE_SIMD_KERNELS = bool (simd);
+        FunctionalSet fused_frozen;
+        fused_frozen.set_ref_vertices (num_labels);
+        FusedMinkowskiFunctionals ff;
+        fused_frozen.attach_to (&ff);
+        ff.add_boundary (FrozenBoundary (b));
+        reference.compare_to (testname + (simd ? " (frozen, simd)" : " (frozen)"),
+                              num_labels, fused_frozen);
+        // the same with the geometry taken from the cache
+        FunctionalSet frozen_cached;
+        frozen_cached.set_ref_vertices (num_labels);
+        FusedMinkowskiFunctionals ffc;
+        frozen_cached.attach_to (&ffc);
+        FrozenBoundary fcached (cached);
+        if (!fcached.has_geometry ()) {
+            std::cerr << testname << ": geometry not taken from the cache\n";
+            failed = true;
+        }
+        ffc.add_boundary (fcached);
+        fused_frozen.compare_to (testname + " (frozen, cached)", num_labels,
+                                 frozen_cached, 0.);
+    }
+    USE_SIMD_KERNELS = true;
+
+    // threaded evaluation, which has to be reproducible
+    for (int threads = 2; threads <= 7; threads += 5) {
+        FunctionalSet first, second;
+        first.set_ref_vertices (num_labels);
+        second.set_ref_vertices (num_labels);
+        FusedMinkowskiFunctionals f1, f2;
+        first.attach_to (&f1);
+        second.attach_to (&f2);
+        f1.num_threads = f2.num_threads = threads;
+        FrozenBoundary frozen (b);
+        f1.add_boundary (frozen);
+        f2.add_boundary (frozen);
+        reference.compare_to (testname + " (threads)", num_labels, first);
+        first.compare_to (testname + " (threads, reproducible)", num_labels,
+                          second, 0.);
+    }
+}
+
+// sliding windows put together from the sums over the cells, against
+// the values of the cells taken about the center of each window.  the
+// edges on the boundary of the clipping rectangle have no label, but
+// those on the dividers do; so if the windows do not overlap, they are
+// also compared to a coarser grid of domains.
+static void test_windows (const std::string &testname, const Boundary &b,
+                          const rect_t &r, int nx, int ny,
+                          int wx, int wy, int sx, int sy) {
+    Boundary cells = b, cells_w0 = b;
+    label_by_domain (&cells, r, nx, ny, false);
+    label_by_domain (&cells_w0, r, nx, ny, true);
+    vec_t center (.5 * (r.left + r.right), .5 * (r.top + r.bottom));
+    std::vector <minkowski_sums_t> sums, windows;
+    minkowski_sums (&sums, cells, cells_w0, nx*ny, center);
+    window_sums (&windows, sums, nx, ny, wx, wy, sx, sy);
+    const int mx = (nx - wx) / sx + 1, my = (ny - wy) / sy + 1;
+    if ((int)windows.size () != mx*my) {
+        std::cerr << testname << ": wrong number of windows\n";
+        failed = true;
+        return;
+    }
+    const bool disjoint = wx == sx && wy == sy && nx % wx == 0 && ny % wy == 0;
+    Boundary coarse = b, coarse_w0 = b;
+    if (disjoint) {
+        label_by_domain (&coarse, r, mx, my, false);
+        label_by_domain (&coarse_w0, r, mx, my, true);
+    }
+    for (int j = 0; j != my; ++j)
+    for (int i = 0; i != mx; ++i) {
+        const int x0 = i*sx, y0 = j*sy;
+        vec_t c = label_domain_center (y0*nx + x0, r, nx, ny);
+        c += label_domain_center ((y0+wy-1)*nx + x0+wx-1, r, nx, ny);
+        c *= .5;
+        minkowski_sums_t s = windows[j*mx + i];
+        vec_t d = c;
+        d -= center;
+        s.translate (d);
+        FunctionalSet summed;
+        FusedMinkowskiFunctionals g;
+        summed.attach_to (&g);
+        g.add_sums (0, s);
+        std::ostringstream name;
+        name << testname << " window (" << i << ", " << j << ")";
+
+        FunctionalSet per_cell;
+        for (int k = 0; k != 11; ++k)
+        for (int l = 0; l != nx*ny; ++l)
+            per_cell.all ()[k]->ref_vertex (l, c);
+        FusedMinkowskiFunctionals f, f_w0;
+        per_cell.attach_to (&f);
+        f.w000 = 0; f.w010 = 0; f.w020 = 0;
+        f_w0.w000 = per_cell.w000;
+        f_w0.w010 = per_cell.w010;
+        f_w0.w020 = per_cell.w020;
+        f.add_boundary (cells);
+        f_w0.add_boundary (cells_w0);
+        // the cells of the window to label 0, the rest away
+        std::vector <int> in_window (nx*ny, 1);
+        for (int y = y0; y != y0 + wy; ++y)
+        for (int x = x0; x != x0 + wx; ++x)
+            in_window[y*nx + x] = 0;
+        f.merge_labels (in_window, 2);
+        f_w0.merge_labels (in_window, 2);
+        per_cell.compare_to (name.str (), 1, summed, 1e-9);
+
+        if (disjoint) {
+            FunctionalSet domain;
+            for (int k = 0; k != 11; ++k)
+                domain.all ()[k]->ref_vertex (j*mx + i, c);
+            FusedMinkowskiFunctionals h, h_w0;
+            domain.attach_to (&h);
+            h.w000 = 0; h.w010 = 0; h.w020 = 0;
+            h_w0.w000 = domain.w000;
+            h_w0.w010 = domain.w010;
+            h_w0.w020 = domain.w020;
+            h.add_boundary (coarse);
+            h_w0.add_boundary (coarse_w0);
+            std::vector <int> only_this (mx*my, 1);
+            only_this[j*mx + i] = 0;
+            h.merge_labels (only_this, 2);
+            h_w0.merge_labels (only_this, 2);
+            domain.compare_to (name.str () + " (coarse)", 1, summed, 1e-9);
+        }
+    }
+}
+
+// a level of the domain pyramid is the same as disjoint 2 x 2 windows
+// (which test_windows compares to the coarser domains)
+static void test_pyramid (const std::string &testname, const Boundary &b,
+                          const rect_t &r, int nx, int ny) {
+    Boundary cells = b, cells_w0 = b;
+    label_by_domain (&cells, r, nx, ny, false);
+    label_by_domain (&cells_w0, r, nx, ny, true);
+    std::vector <minkowski_sums_t> sums, coarser, windows;
+    minkowski_sums (&sums, cells, cells_w0, nx*ny, vec_t (0., 0.));
+    coarser_domains (&coarser, sums, nx, ny);
+    window_sums (&windows, sums, nx, ny, 2, 2, 2, 2);
+    FunctionalSet from_tree, from_windows;
+    FusedMinkowskiFunctionals f, g;
+    from_tree.attach_to (&f);
+    from_windows.attach_to (&g);
+    for (int l = 0; l != (int)windows.size (); ++l) {
+        f.add_sums (l, coarser.at (l));
+        g.add_sums (l, windows[l]);
+    }
+    from_windows.compare_to (testname + " (pyramid)", nx*ny/4, from_tree, 1e-9);
+}
+
+int main () {
+    std::cerr << "Testing fused functionals...\n";
+
+    {
+        Boundary b;
+        load_poly (&b, "counterexample.poly");
+        int num_labels = label_by_contour_index (&b);
+        test_boundary ("counterexample.poly", b, num_labels);
+    }
+
+    {
+        Boundary b;
+        load_poly (&b, "circle-d=1k.poly");
+        // the POINTS parsed in parallel give the same boundary
+        Boundary c;
+        load_poly (&c, "circle-d=1k.poly", 3);
+        FrozenBoundary fb (b), fc (c);
+        if (fb.num_edges () != fc.num_edges () ||
+            !std::equal (fb.x (), fb.x () + fb.num_edges (), fc.x ()) ||
+            !std::equal (fb.y (), fb.y () + fb.num_edges (), fc.y ())) {
+            std::cerr << "circle-d=1k.poly: parallel POLY parsing differs\n";
+            failed = true;
+        }
+        int num_labels = label_none (&b);
+        test_boundary ("circle-d=1k.poly", b, num_labels);
+    }
+
+    // only numbers which operator>> takes, not inf, nan or hexadecimal
+    const char *not_numbers[] = { "inf", "nan", "0x1p3" };
+    for (int i = 0; i != 3; ++i) {
+        const char *filename = "not_a_number.poly";
+        {
+            std::ofstream os (filename);
+            os << "POINTS\n1: 0 0 0\n2: " << not_numbers[i]
+               << " 0 0\n3: 1 1 0\nPOLYS\n1: 1 2 3 <\nEND\n";
+        }
+        bool thrown = false;
+        try {
+            Boundary b;
+            load_poly (&b, filename);
+        } catch (std::runtime_error &) {
+            thrown = true;
+        }
+        remove (filename);
+        if (!thrown) {
+            std::cerr << "POLY file with " << not_numbers[i] << " accepted\n";
+            failed = true;
+        }
+    }
+
+    {
+        Pixmap p;
+        load_pgm (&p, "ma105_7o_cropped.pgm");
+        Boundary b;
+        marching_squares (&b, p, .95, false, false);
+        int num_labels = label_by_component (&b);
+        test_boundary ("ma105_7o_cropped.pgm by_component", b, num_labels);
+    }
+
+    {
+        // binary polygon files, with labels and in single precision
+        Pixmap p;
+        load_pgm (&p, "ma105_7o_cropped.pgm");
+        Boundary b;
+        marching_squares (&b, p, .95, false, false);
+        label_by_component (&b);
+        for (int single = 0; single != 2; ++single) {
+            save_bpoly ("functionals.bpoly.tmp", b, true, single);
+            Boundary c;
+            load_bpoly (&c, "functionals.bpoly.tmp");
+            FrozenBoundary fb (b), fc (c);
+            bool same = fb.num_contours () == fc.num_contours () &&
+                        fb.num_edges () == fc.num_edges ();
+            for (int i = 0; same && i != fb.num_edges (); ++i)
+                same = fb.labels ()[i] == fc.labels ()[i] &&
+                       fc.x ()[i] == (single ? float (fb.x ()[i]) : fb.x ()[i]) &&
+                       fc.y ()[i] == (single ? float (fb.y ()[i]) : fb.y ()[i]);
+            if (!same) {
+                std::cerr << "binary polygon file differs (single precision = "
+                          << single << ")\n";
+                failed = true;
+            }
+        }
+        remove ("functionals.bpoly.tmp");
+    }
+
+    {
+        // by_domain labelling leaves some edges with NO_LABEL
+        Pixmap p;
+        load_pgm (&p, "ma105_7o_cropped.pgm");
+        Boundary b;
+        marching_squares (&b, p, .95, false, false);
+        rect_t r;
+        r.left = 10.;
+        r.right = 110.;
+        r.top = 110.;
+        r.bottom = 10.;
+        Boundary c = b;
+        int num_labels = label_by_domain (&b, r, 10, 10, false);
+        test_boundary ("ma105_7o_cropped.pgm by_domain", b, num_labels);
+        // overlapping, and disjoint windows
+        test_windows ("ma105_7o_cropped.pgm", c, r, 10, 10, 3, 2, 2, 3);
+        test_windows ("ma105_7o_cropped.pgm", c, r, 10, 10, 5, 5, 5, 5);
+        test_pyramid ("ma105_7o_cropped.pgm", c, r, 10, 10);
+    }
+
+    return int (failed);
+}
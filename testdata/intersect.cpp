@@ -0,0 +1,136 @@
+// vim: et:sw=4:ts=4
+// compare the intersections found with an EdgeGrid, or from a list of
+// edges, against the ones found by testing every edge.
+
+#include <iostream>
+#include "../intersect.h"
+
+static bool failed = false;
+
+static bool same_intersections (const intersect_buffer_t &a,
+                                const intersect_buffer_t &b) {
+    if (a.size () != b.size ())
+        return false;
+    for (size_t i = 0; i != a.size (); ++i) {
+        if (a[i].iedge != b[i].iedge || a[i].sign != b[i].sign ||
+            a[i].inc != b[i].inc ||
+            a[i].ivtx[0] != b[i].ivtx[0] || a[i].ivtx[1] != b[i].ivtx[1])
+            return false;
+    }
+    return true;
+}
+
+// coinciding intersections may come in any order
+static bool by_everything (const intersect_info_t &a, const intersect_info_t &b) {
+    if (a.inc != b.inc)
+        return a.inc < b.inc;
+    if (a.sign != b.sign)
+        return a.sign < b.sign;
+    return &*a.iedge < &*b.iedge;
+}
+
+static bool same_edges (const intersect_info_t &a, const intersect_info_t &b) {
+    return &*a.iedge == &*b.iedge;
+}
+
+static void compare (const std::string &testname, Boundary *b,
+                     const vec_t &r0, const vec_t &dir, const EdgeGrid &grid,
+                     const std::vector <Boundary::edge_iterator> &all_edges) {
+    intersect_buffer_t scan, fast;
+    intersect_line_boundary (&scan, r0, dir, b);
+    intersect_line_boundary (&fast, r0, dir, b, &grid);
+    if (!same_intersections (scan, fast)) {
+        std::cerr << testname << ": line through (" << r0[0] << ", " << r0[1]
+                  << ") differs with the grid\n";
+        failed = true;
+    }
+    // the same from a list of the edges
+    intersect_buffer_t listed;
+    intersect_line_edges (&listed, r0, dir, *b, all_edges);
+    std::sort (scan.begin (), scan.end (), by_everything);
+    std::sort (listed.begin (), listed.end (), by_everything);
+    bool same = scan.size () == listed.size ();
+    for (size_t i = 0; same && i != scan.size (); ++i)
+        same = same_edges (scan[i], listed[i]) && scan[i].sign == listed[i].sign &&
+               scan[i].inc == listed[i].inc;
+    if (!same) {
+        std::cerr << testname << ": line through (" << r0[0] << ", " << r0[1]
+                  << ") differs for a list of edges\n";
+        failed = true;
+    }
+    scan.clear ();
+    fast.clear ();
+    intersect_ray_boundary (&scan, r0, dir, b);
+    intersect_ray_boundary (&fast, r0, dir, b, &grid);
+    if (!same_intersections (scan, fast)) {
+        std::cerr << testname << ": ray from (" << r0[0] << ", " << r0[1]
+                  << ") differs with the grid\n";
+        failed = true;
+    }
+}
+
+// lines in a few directions through points of a lattice, which hit
+// vertices of marching squares output, and through the vertices of
+// the boundary in the direction of the normal
+static void test_boundary (const std::string &testname, Boundary *b) {
+    EdgeGrid grid (*b);
+    FrozenBoundary f (*b);
+    // all the edges, in reverse order
+    std::vector <Boundary::edge_iterator> all_edges;
+    Boundary::contour_iterator cit;
+    Boundary::edge_iterator eit;
+    for (cit = b->contours_begin (); cit != b->contours_end (); ++cit)
+    for (eit = b->edges_begin (cit); eit != b->edges_end (cit); ++eit)
+        all_edges.push_back (eit);
+    std::reverse (all_edges.begin (), all_edges.end ());
+    double x0 = f.x ()[0], x1 = x0, y0 = f.y ()[0], y1 = y0;
+    for (int i = 0; i != f.num_edges (); ++i) {
+        x0 = std::min (x0, f.x ()[i]);
+        x1 = std::max (x1, f.x ()[i]);
+        y0 = std::min (y0, f.y ()[i]);
+        y1 = std::max (y1, f.y ()[i]);
+    }
+    const vec_t dirs[] = { vec_t (1., 0.), vec_t (0., 1.), vec_t (-1., 0.),
+                           vec_t (1., 1.), vec_t (-2., 1.), vec_t (.3, -.7) };
+    for (int k = 0; k != 6; ++k)
+    for (int j = -1; j <= 11; ++j)
+    for (int i = -1; i <= 11; ++i) {
+        vec_t r0 (x0 + (x1 - x0) * .1 * i, y0 + (y1 - y0) * .1 * j);
+        // on the half-integer lattice
+        compare (testname, b, vec_t (floor (r0[0]) + .5, floor (r0[1]) + .5),
+                 dirs[k], grid, all_edges);
+        compare (testname, b, r0, dirs[k], grid, all_edges);
+    }
+    for (cit = b->contours_begin (); cit != b->contours_end (); ++cit)
+        compare (testname, b, b->edge_vertex0 (b->edges_begin (cit)),
+                 b->edge_normal (b->edges_begin (cit)), grid, all_edges);
+}
+
+int main () {
+    std::cerr << "Testing intersections with an edge grid...\n";
+
+    {
+        Pixmap p;
+        load_pgm (&p, "ma105_7o_cropped.pgm");
+        Boundary b;
+        marching_squares (&b, p, .95, false, false);
+        test_boundary ("ma105_7o_cropped.pgm", &b);
+        Boundary c;
+        marching_squares (&c, p, .5, true, false, 1, true);
+        test_boundary ("ma105_7o_cropped.pgm interpolated", &c);
+    }
+
+    {
+        Boundary b;
+        load_poly (&b, "circle-d=1k.poly");
+        test_boundary ("circle-d=1k.poly", &b);
+    }
+
+    {
+        Boundary b;
+        load_poly (&b, "counterexample.poly");
+        test_boundary ("counterexample.poly", &b);
+    }
+
+    return int (failed);
+}
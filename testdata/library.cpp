@@ -0,0 +1,167 @@
+// vim: et:sw=4:ts=4
+// evaluate images and polygons in memory through libpapaya, and compare
+// the different ways in against each other and a square.
+
+#include <iostream>
+#include <stdexcept>
+#include "../libpapaya_internal.h"
+
+static bool failed = false;
+
+static void check (bool ok, const std::string &what) {
+    if (!ok) {
+        std::cerr << "library: " << what << "\n";
+        failed = true;
+    }
+}
+
+static bool close (double a, double b) {
+    return fabs (a - b) <= 1e-9 * (1. + fabs (b));
+}
+
+static bool same_results (const papaya_results_t &a, const papaya_results_t &b) {
+    return a.num_labels == b.num_labels &&
+           a.w000 == b.w000 && a.w100 == b.w100 && a.w200 == b.w200 &&
+           a.w010 == b.w010 && a.w110 == b.w110 && a.w210 == b.w210 &&
+           a.w020 == b.w020 && a.w120 == b.w120 && a.w102 == b.w102 &&
+           a.w220 == b.w220 && a.w211 == b.w211 &&
+           a.ref_vertex == b.ref_vertex;
+}
+
+static double total (const std::vector <double> &v) {
+    double ret = 0.;
+    for (size_t i = 0; i != v.size (); ++i)
+        ret += v[i];
+    return ret;
+}
+
+// the square [0, 2]^2 about its center
+static void test_square () {
+    const int begin[] = { 0, 4 };
+    const double x[] = { 0., 2., 2., 0. }, y[] = { 0., 0., 2., 2. };
+    papaya_options_t opt;
+    opt.point_of_reference = "component_com";
+    papaya_results_t res;
+    papaya_evaluate_polygons (&res, 1, begin, x, y, opt);
+    check (res.num_labels == 1, "square: number of labels");
+    check (close (res.w000[0], 4. * W0_NORMALIZATION), "square: W000");
+    check (close (res.w100[0], 8. * W1_NORMALIZATION), "square: W100");
+    check (close (res.w200[0], 2. * M_PI * W2_NORMALIZATION), "square: W200");
+    check (close (res.ref_vertex[0], 1.) && close (res.ref_vertex[1], 1.),
+           "square: point of reference");
+    check (close (res.w020[0], 4./3. * W0_NORMALIZATION) &&
+           close (res.w020[1], 0.) && close (res.w020[2], 0.) &&
+           close (res.w020[3], 4./3. * W0_NORMALIZATION), "square: W020");
+}
+
+static void test_image (const std::string &filename) {
+    Pixmap pgm;
+    load_pgm (&pgm, filename);
+    const Pixmap &image = pgm;
+    papaya_options_t opt;
+    opt.threshold = .5;
+    opt.periodic_data = true;
+    opt.point_of_reference = "component_cos";
+    papaya_results_t from_pixmap, from_pixels, from_polygons;
+    papaya_evaluate_image (&from_pixmap, image, opt);
+
+    // the same from an array of pixels
+    std::vector <double> pixels;
+    for (int y = 0; y != image.size2 (); ++y)
+    for (int x = 0; x != image.size1 (); ++x)
+        pixels.push_back (image (x, y));
+    papaya_evaluate_image (&from_pixels, &pixels[0], image.size1 (),
+                           image.size2 (), opt);
+    check (same_results (from_pixmap, from_pixels),
+           filename + ": pixels differ from the Pixmap");
+
+    // and from the contours of the image
+    Boundary b;
+    marching_squares (&b, image, opt.threshold, opt.connectblack,
+                      opt.periodic_data);
+    FrozenBoundary f (b);
+    std::vector <int> begin;
+    for (int c = 0; c != f.num_contours (); ++c)
+        begin.push_back (f.contour_begin (c));
+    begin.push_back (f.num_edges ());
+    opt.fix_contours = opt.force_counterclockwise = false;
+    papaya_evaluate_polygons (&from_polygons, f.num_contours (), &begin[0],
+                              f.x (), f.y (), opt);
+    check (same_results (from_pixmap, from_polygons),
+           filename + ": polygons differ from the image");
+
+    // the domains add up to the whole image.  without periodic data,
+    // where they don't quite (with the papaya program just the same).
+    papaya_results_t whole, domains;
+    opt.periodic_data = false;
+    opt.labels = "by_domain";
+    opt.point_of_reference = "origin";
+    // with some room, since edges on the border of the clipping
+    // rectangle are left out
+    opt.clip_left = opt.clip_bottom = -1.;
+    opt.clip_right = image.size1 () + 1.;
+    opt.clip_top = image.size2 () + 1.;
+    opt.xdomains = 4;
+    opt.ydomains = 3;
+    papaya_evaluate_image (&domains, image, opt);
+    opt.labels = "none";
+    papaya_evaluate_image (&whole, image, opt);
+    check (domains.num_labels == 12, filename + ": number of domains");
+    check (close (total (domains.w000), whole.w000[0]),
+           filename + ": W000 of the domains");
+    check (close (total (domains.w100), whole.w100[0]),
+           filename + ": W100 of the domains");
+    check (close (total (domains.w200), whole.w200[0]),
+           filename + ": W200 of the domains");
+}
+
+static bool throws (int num_contours, const int *begin,
+                    const double *x, const double *y,
+                    const papaya_options_t &opt) {
+    papaya_results_t res;
+    try {
+        papaya_evaluate_polygons (&res, num_contours, begin, x, y, opt);
+    } catch (std::runtime_error &) {
+        return true;
+    }
+    return false;
+}
+
+// errors have to come as exceptions, also those which papaya reports
+// with die ()
+static void test_errors () {
+    const int begin[] = { 0, 4 };
+    const double x[] = { 0., 2., 2., 0. }, y[] = { 0., 0., 2., 2. };
+    papaya_options_t opt;
+    opt.labels = "by_everything";
+    check (throws (1, begin, x, y, opt), "invalid labels accepted");
+    opt.labels = "by_contour";
+    opt.point_of_reference = "domain_center";
+    check (throws (1, begin, x, y, opt), "invalid point of reference accepted");
+
+    // a lone clockwise contour is a hole in nothing
+    const double cw_x[] = { 0., 0., 2., 2. }, cw_y[] = { 0., 2., 2., 0. };
+    opt = papaya_options_t ();
+    opt.force_counterclockwise = false;
+    check (throws (1, begin, cw_x, cw_y, opt), "lone clockwise contour accepted");
+
+    // a square with a square hole has no total curvature
+    const int ring_begin[] = { 0, 4, 8 };
+    const double ring_x[] = { 0., 4., 4., 0., 1., 1., 3., 3. };
+    const double ring_y[] = { 0., 0., 4., 4., 1., 3., 3., 1. };
+    opt.point_of_reference = "component_coc";
+    check (throws (2, ring_begin, ring_x, ring_y, opt),
+           "center of curvature of a ring accepted");
+    opt.point_of_reference = "component_com";
+    check (!throws (2, ring_begin, ring_x, ring_y, opt),
+           "center of mass of a ring rejected");
+}
+
+int main () {
+    std::cerr << "Testing the library interface...\n";
+    test_square ();
+    test_image ("slika.pgm");
+    test_image ("ma105_7o_cropped.pgm");
+    test_errors ();
+    return int (failed);
+}
@@ -0,0 +1,219 @@
+unset key
+plot \
+	"ma105_7o_cropped.out/nu0labels.out" index 0 w lp lt 38 pt 38\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 1 w lp lt 1 pt 1\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 2 w lp lt 52 pt 52\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 3 w lp lt 92 pt 92\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 4 w lp lt 27 pt 27\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 5 w lp lt 85 pt 85\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 6 w lp lt 60 pt 60\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 7 w lp lt 2 pt 2\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 8 w lp lt 100 pt 100\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 9 w lp lt 39 pt 39\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 10 w lp lt 53 pt 53\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 11 w lp lt 5 pt 5\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 12 w lp lt 32 pt 32\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 13 w lp lt 34 pt 34\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 14 w lp lt 15 pt 15\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 15 w lp lt 45 pt 45\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 16 w lp lt 33 pt 33\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 17 w lp lt 31 pt 31\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 18 w lp lt 7 pt 7\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 19 w lp lt 26 pt 26\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 20 w lp lt 47 pt 47\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 21 w lp lt 83 pt 83\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 22 w lp lt 3 pt 3\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 23 w lp lt 4 pt 4\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 24 w lp lt 5 pt 5\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 25 w lp lt 6 pt 6\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 26 w lp lt 7 pt 7\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 27 w lp lt 8 pt 8\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 28 w lp lt 9 pt 9\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 29 w lp lt 10 pt 10\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 30 w lp lt 11 pt 11\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 31 w lp lt 12 pt 12\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 32 w lp lt 13 pt 13\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 33 w lp lt 14 pt 14\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 34 w lp lt 16 pt 16\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 35 w lp lt 17 pt 17\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 36 w lp lt 18 pt 18\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 37 w lp lt 19 pt 19\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 38 w lp lt 20 pt 20\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 39 w lp lt 21 pt 21\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 40 w lp lt 22 pt 22\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 41 w lp lt 23 pt 23\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 42 w lp lt 24 pt 24\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 43 w lp lt 25 pt 25\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 44 w lp lt 27 pt 27\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 45 w lp lt 28 pt 28\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 46 w lp lt 29 pt 29\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 47 w lp lt 30 pt 30\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 48 w lp lt 32 pt 32\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 49 w lp lt 33 pt 33\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 50 w lp lt 35 pt 35\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 51 w lp lt 36 pt 36\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 52 w lp lt 37 pt 37\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 53 w lp lt 37 pt 37\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 54 w lp lt 39 pt 39\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 55 w lp lt 40 pt 40\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 56 w lp lt 41 pt 41\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 57 w lp lt 42 pt 42\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 58 w lp lt 43 pt 43\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 59 w lp lt 44 pt 44\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 60 w lp lt 46 pt 46\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 61 w lp lt 47 pt 47\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 62 w lp lt 48 pt 48\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 63 w lp lt 49 pt 49\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 64 w lp lt 50 pt 50\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 65 w lp lt 51 pt 51\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 66 w lp lt 54 pt 54\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 67 w lp lt 55 pt 55\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 68 w lp lt 56 pt 56\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 69 w lp lt 57 pt 57\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 70 w lp lt 58 pt 58\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 71 w lp lt 59 pt 59\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 72 w lp lt 61 pt 61\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 73 w lp lt 62 pt 62\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 74 w lp lt 63 pt 63\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 75 w lp lt 64 pt 64\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 76 w lp lt 65 pt 65\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 77 w lp lt 66 pt 66\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 78 w lp lt 67 pt 67\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 79 w lp lt 68 pt 68\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 80 w lp lt 69 pt 69\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 81 w lp lt 70 pt 70\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 82 w lp lt 71 pt 71\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 83 w lp lt 72 pt 72\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 84 w lp lt 73 pt 73\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 85 w lp lt 74 pt 74\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 86 w lp lt 75 pt 75\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 87 w lp lt 76 pt 76\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 88 w lp lt 77 pt 77\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 89 w lp lt 78 pt 78\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 90 w lp lt 79 pt 79\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 91 w lp lt 80 pt 80\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 92 w lp lt 81 pt 81\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 93 w lp lt 82 pt 82\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 94 w lp lt 83 pt 83\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 95 w lp lt 84 pt 84\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 96 w lp lt 86 pt 86\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 97 w lp lt 87 pt 87\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 98 w lp lt 88 pt 88\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 99 w lp lt 89 pt 89\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 100 w lp lt 90 pt 90\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 101 w lp lt 91 pt 91\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 102 w lp lt 93 pt 93\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 103 w lp lt 94 pt 94\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 104 w lp lt 96 pt 96\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 105 w lp lt 97 pt 97\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 106 w lp lt 98 pt 98\
+	,\
+	"ma105_7o_cropped.out/nu0labels.out" index 107 w lp lt 99 pt 99\
+	,\
+	(1./0)
@@ -0,0 +1,635 @@
+unset key
+plot \
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 0 w lp lt 226 pt 226\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 1 w lp lt 339 pt 339\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 2 w lp lt 2 pt 2\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 3 w lp lt 349 pt 349\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 4 w lp lt 241 pt 241\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 5 w lp lt 204 pt 204\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 6 w lp lt 160 pt 160\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 7 w lp lt 278 pt 278\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 8 w lp lt 261 pt 261\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 9 w lp lt 156 pt 156\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 10 w lp lt 380 pt 380\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 11 w lp lt 1 pt 1\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 12 w lp lt 157 pt 157\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 13 w lp lt 234 pt 234\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 14 w lp lt 383 pt 383\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 15 w lp lt 3 pt 3\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 16 w lp lt 282 pt 282\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 17 w lp lt 190 pt 190\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 18 w lp lt 183 pt 183\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 19 w lp lt 24 pt 24\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 20 w lp lt 382 pt 382\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 21 w lp lt 126 pt 126\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 22 w lp lt 28 pt 28\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 23 w lp lt 122 pt 122\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 24 w lp lt 127 pt 127\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 25 w lp lt 49 pt 49\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 26 w lp lt 148 pt 148\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 27 w lp lt 29 pt 29\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 28 w lp lt 169 pt 169\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 29 w lp lt 105 pt 105\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 30 w lp lt 205 pt 205\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 31 w lp lt 123 pt 123\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 32 w lp lt 121 pt 121\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 33 w lp lt 191 pt 191\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 34 w lp lt 13 pt 13\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 35 w lp lt 239 pt 239\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 36 w lp lt 14 pt 14\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 37 w lp lt 364 pt 364\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 38 w lp lt 70 pt 70\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 39 w lp lt 91 pt 91\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 40 w lp lt 325 pt 325\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 41 w lp lt 174 pt 174\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 42 w lp lt 93 pt 93\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 43 w lp lt 395 pt 395\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 44 w lp lt 92 pt 92\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 45 w lp lt 58 pt 58\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 46 w lp lt 155 pt 155\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 47 w lp lt 4 pt 4\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 48 w lp lt 5 pt 5\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 49 w lp lt 6 pt 6\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 50 w lp lt 7 pt 7\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 51 w lp lt 8 pt 8\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 52 w lp lt 9 pt 9\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 53 w lp lt 11 pt 11\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 54 w lp lt 12 pt 12\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 55 w lp lt 15 pt 15\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 56 w lp lt 16 pt 16\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 57 w lp lt 17 pt 17\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 58 w lp lt 18 pt 18\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 59 w lp lt 19 pt 19\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 60 w lp lt 20 pt 20\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 61 w lp lt 25 pt 25\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 62 w lp lt 26 pt 26\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 63 w lp lt 27 pt 27\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 64 w lp lt 29 pt 29\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 65 w lp lt 30 pt 30\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 66 w lp lt 31 pt 31\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 67 w lp lt 32 pt 32\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 68 w lp lt 33 pt 33\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 69 w lp lt 35 pt 35\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 70 w lp lt 36 pt 36\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 71 w lp lt 37 pt 37\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 72 w lp lt 38 pt 38\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 73 w lp lt 39 pt 39\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 74 w lp lt 40 pt 40\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 75 w lp lt 41 pt 41\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 76 w lp lt 42 pt 42\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 77 w lp lt 45 pt 45\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 78 w lp lt 46 pt 46\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 79 w lp lt 47 pt 47\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 80 w lp lt 50 pt 50\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 81 w lp lt 51 pt 51\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 82 w lp lt 52 pt 52\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 83 w lp lt 53 pt 53\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 84 w lp lt 55 pt 55\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 85 w lp lt 56 pt 56\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 86 w lp lt 57 pt 57\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 87 w lp lt 59 pt 59\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 88 w lp lt 60 pt 60\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 89 w lp lt 61 pt 61\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 90 w lp lt 62 pt 62\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 91 w lp lt 63 pt 63\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 92 w lp lt 65 pt 65\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 93 w lp lt 66 pt 66\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 94 w lp lt 67 pt 67\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 95 w lp lt 71 pt 71\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 96 w lp lt 72 pt 72\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 97 w lp lt 73 pt 73\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 98 w lp lt 75 pt 75\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 99 w lp lt 76 pt 76\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 100 w lp lt 77 pt 77\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 101 w lp lt 79 pt 79\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 102 w lp lt 80 pt 80\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 103 w lp lt 81 pt 81\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 104 w lp lt 82 pt 82\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 105 w lp lt 83 pt 83\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 106 w lp lt 85 pt 85\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 107 w lp lt 86 pt 86\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 108 w lp lt 87 pt 87\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 109 w lp lt 88 pt 88\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 110 w lp lt 89 pt 89\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 111 w lp lt 94 pt 94\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 112 w lp lt 95 pt 95\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 113 w lp lt 96 pt 96\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 114 w lp lt 97 pt 97\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 115 w lp lt 99 pt 99\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 116 w lp lt 100 pt 100\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 117 w lp lt 101 pt 101\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 118 w lp lt 102 pt 102\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 119 w lp lt 103 pt 103\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 120 w lp lt 106 pt 106\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 121 w lp lt 107 pt 107\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 122 w lp lt 108 pt 108\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 123 w lp lt 109 pt 109\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 124 w lp lt 110 pt 110\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 125 w lp lt 114 pt 114\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 126 w lp lt 115 pt 115\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 127 w lp lt 116 pt 116\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 128 w lp lt 117 pt 117\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 129 w lp lt 119 pt 119\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 130 w lp lt 120 pt 120\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 131 w lp lt 123 pt 123\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 132 w lp lt 124 pt 124\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 133 w lp lt 128 pt 128\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 134 w lp lt 129 pt 129\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 135 w lp lt 130 pt 130\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 136 w lp lt 131 pt 131\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 137 w lp lt 132 pt 132\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 138 w lp lt 134 pt 134\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 139 w lp lt 135 pt 135\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 140 w lp lt 136 pt 136\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 141 w lp lt 137 pt 137\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 142 w lp lt 139 pt 139\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 143 w lp lt 140 pt 140\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 144 w lp lt 143 pt 143\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 145 w lp lt 144 pt 144\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 146 w lp lt 145 pt 145\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 147 w lp lt 146 pt 146\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 148 w lp lt 149 pt 149\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 149 w lp lt 150 pt 150\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 150 w lp lt 151 pt 151\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 151 w lp lt 152 pt 152\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 152 w lp lt 153 pt 153\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 153 w lp lt 154 pt 154\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 154 w lp lt 158 pt 158\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 155 w lp lt 159 pt 159\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 156 w lp lt 161 pt 161\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 157 w lp lt 163 pt 163\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 158 w lp lt 164 pt 164\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 159 w lp lt 165 pt 165\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 160 w lp lt 166 pt 166\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 161 w lp lt 170 pt 170\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 162 w lp lt 171 pt 171\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 163 w lp lt 172 pt 172\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 164 w lp lt 173 pt 173\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 165 w lp lt 174 pt 174\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 166 w lp lt 177 pt 177\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 167 w lp lt 178 pt 178\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 168 w lp lt 179 pt 179\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 169 w lp lt 181 pt 181\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 170 w lp lt 182 pt 182\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 171 w lp lt 184 pt 184\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 172 w lp lt 185 pt 185\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 173 w lp lt 186 pt 186\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 174 w lp lt 187 pt 187\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 175 w lp lt 192 pt 192\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 176 w lp lt 193 pt 193\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 177 w lp lt 194 pt 194\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 178 w lp lt 196 pt 196\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 179 w lp lt 197 pt 197\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 180 w lp lt 198 pt 198\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 181 w lp lt 199 pt 199\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 182 w lp lt 201 pt 201\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 183 w lp lt 202 pt 202\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 184 w lp lt 206 pt 206\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 185 w lp lt 207 pt 207\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 186 w lp lt 208 pt 208\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 187 w lp lt 209 pt 209\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 188 w lp lt 212 pt 212\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 189 w lp lt 213 pt 213\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 190 w lp lt 214 pt 214\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 191 w lp lt 216 pt 216\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 192 w lp lt 217 pt 217\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 193 w lp lt 218 pt 218\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 194 w lp lt 219 pt 219\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 195 w lp lt 221 pt 221\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 196 w lp lt 222 pt 222\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 197 w lp lt 227 pt 227\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 198 w lp lt 228 pt 228\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 199 w lp lt 229 pt 229\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 200 w lp lt 231 pt 231\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 201 w lp lt 232 pt 232\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 202 w lp lt 233 pt 233\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 203 w lp lt 236 pt 236\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 204 w lp lt 237 pt 237\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 205 w lp lt 238 pt 238\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 206 w lp lt 242 pt 242\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 207 w lp lt 243 pt 243\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 208 w lp lt 244 pt 244\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 209 w lp lt 245 pt 245\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 210 w lp lt 247 pt 247\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 211 w lp lt 248 pt 248\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 212 w lp lt 249 pt 249\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 213 w lp lt 251 pt 251\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 214 w lp lt 252 pt 252\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 215 w lp lt 253 pt 253\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 216 w lp lt 256 pt 256\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 217 w lp lt 257 pt 257\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 218 w lp lt 258 pt 258\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 219 w lp lt 260 pt 260\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 220 w lp lt 262 pt 262\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 221 w lp lt 263 pt 263\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 222 w lp lt 264 pt 264\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 223 w lp lt 265 pt 265\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 224 w lp lt 267 pt 267\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 225 w lp lt 268 pt 268\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 226 w lp lt 269 pt 269\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 227 w lp lt 271 pt 271\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 228 w lp lt 272 pt 272\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 229 w lp lt 273 pt 273\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 230 w lp lt 275 pt 275\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 231 w lp lt 276 pt 276\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 232 w lp lt 277 pt 277\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 233 w lp lt 280 pt 280\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 234 w lp lt 283 pt 283\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 235 w lp lt 284 pt 284\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 236 w lp lt 285 pt 285\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 237 w lp lt 287 pt 287\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 238 w lp lt 288 pt 288\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 239 w lp lt 289 pt 289\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 240 w lp lt 291 pt 291\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 241 w lp lt 292 pt 292\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 242 w lp lt 293 pt 293\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 243 w lp lt 295 pt 295\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 244 w lp lt 296 pt 296\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 245 w lp lt 297 pt 297\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 246 w lp lt 299 pt 299\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 247 w lp lt 300 pt 300\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 248 w lp lt 302 pt 302\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 249 w lp lt 303 pt 303\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 250 w lp lt 304 pt 304\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 251 w lp lt 305 pt 305\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 252 w lp lt 307 pt 307\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 253 w lp lt 308 pt 308\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 254 w lp lt 309 pt 309\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 255 w lp lt 311 pt 311\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 256 w lp lt 312 pt 312\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 257 w lp lt 313 pt 313\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 258 w lp lt 315 pt 315\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 259 w lp lt 316 pt 316\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 260 w lp lt 317 pt 317\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 261 w lp lt 319 pt 319\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 262 w lp lt 320 pt 320\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 263 w lp lt 322 pt 322\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 264 w lp lt 323 pt 323\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 265 w lp lt 324 pt 324\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 266 w lp lt 326 pt 326\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 267 w lp lt 327 pt 327\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 268 w lp lt 328 pt 328\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 269 w lp lt 329 pt 329\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 270 w lp lt 331 pt 331\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 271 w lp lt 332 pt 332\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 272 w lp lt 333 pt 333\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 273 w lp lt 335 pt 335\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 274 w lp lt 336 pt 336\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 275 w lp lt 337 pt 337\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 276 w lp lt 338 pt 338\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 277 w lp lt 340 pt 340\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 278 w lp lt 341 pt 341\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 279 w lp lt 342 pt 342\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 280 w lp lt 343 pt 343\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 281 w lp lt 344 pt 344\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 282 w lp lt 346 pt 346\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 283 w lp lt 347 pt 347\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 284 w lp lt 348 pt 348\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 285 w lp lt 351 pt 351\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 286 w lp lt 352 pt 352\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 287 w lp lt 353 pt 353\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 288 w lp lt 355 pt 355\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 289 w lp lt 356 pt 356\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 290 w lp lt 357 pt 357\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 291 w lp lt 358 pt 358\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 292 w lp lt 360 pt 360\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 293 w lp lt 361 pt 361\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 294 w lp lt 362 pt 362\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 295 w lp lt 363 pt 363\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 296 w lp lt 366 pt 366\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 297 w lp lt 367 pt 367\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 298 w lp lt 368 pt 368\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 299 w lp lt 371 pt 371\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 300 w lp lt 372 pt 372\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 301 w lp lt 373 pt 373\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 302 w lp lt 375 pt 375\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 303 w lp lt 376 pt 376\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 304 w lp lt 377 pt 377\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 305 w lp lt 378 pt 378\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 306 w lp lt 381 pt 381\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 307 w lp lt 386 pt 386\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 308 w lp lt 387 pt 387\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 309 w lp lt 388 pt 388\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 310 w lp lt 391 pt 391\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 311 w lp lt 392 pt 392\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 312 w lp lt 393 pt 393\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 313 w lp lt 396 pt 396\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 314 w lp lt 397 pt 397\
+	,\
+	"ma105_7o_cropped.pyramid.out/nu0labels.out" index 315 w lp lt 398 pt 398\
+	,\
+	(1./0)
@@ -0,0 +1 @@
+plot "ma105_7o_cropped.threads.out/contours.out" w lp
@@ -0,0 +1,263 @@
+// vim: et:sw=4:ts=4
+// compare the tiled and streaming marching squares against the serial code,
+// images with integer storage against float storage,
+// the components found while streaming against label_by_component, also
+// with many components,
+// and its plane sweep against casting rays.
+// the level set sweep is checked against measuring the contours.
+
+#include <iostream>
+#include "../util.h"
+
+static bool failed = false;
+
+// the contours have to agree exactly, including their order and the
+// vertex at which they start.
+static bool same_boundary (const Boundary &a, const Boundary &b) {
+    Boundary::contour_iterator ca = a.contours_begin ();
+    Boundary::contour_iterator cb = b.contours_begin ();
+    for (; ca != a.contours_end () && cb != b.contours_end (); ++ca, ++cb) {
+        Boundary::edge_iterator ea = a.edges_begin (ca);
+        Boundary::edge_iterator eb = b.edges_begin (cb);
+        for (; ea != a.edges_end (ca) && eb != b.edges_end (cb); ++ea, ++eb) {
+            if (a.edge_vertex0 (ea)[0] != b.edge_vertex0 (eb)[0] ||
+                a.edge_vertex0 (ea)[1] != b.edge_vertex0 (eb)[1])
+                return false;
+        }
+        if (ea != a.edges_end (ca) || eb != b.edges_end (cb))
+            return false;
+    }
+    return ca == a.contours_end () && cb == b.contours_end ();
+}
+
+typedef std::vector <std::pair <double, double> > contour_t;
+typedef std::pair <int, contour_t> labelled_contour_t;
+
+// the labelled contours, each rotated to start at its smallest vertex,
+// in order.  every vertex occurs only once in the output of marching
+// squares.  the labels are mapped through new_label, if it is given.
+static std::vector <labelled_contour_t> canonical_contours (
+        const FrozenBoundary &b, const std::vector <int> &new_label
+                                 = std::vector <int> ()) {
+    std::vector <labelled_contour_t> ret (b.num_contours ());
+    for (int c = 0; c != b.num_contours (); ++c) {
+        int label = b.labels ()[b.contour_begin (c)];
+        ret[c].first = new_label.empty () ? label : new_label.at (label);
+        contour_t &contour = ret[c].second;
+        for (int i = b.contour_begin (c); i != b.contour_end (c); ++i)
+            contour.push_back (std::make_pair (b.y ()[i], b.x ()[i]));
+        std::rotate (contour.begin (),
+                     std::min_element (contour.begin (), contour.end ()),
+                     contour.end ());
+    }
+    std::sort (ret.begin (), ret.end ());
+    return ret;
+}
+
+// collect everything in one FrozenBoundary
+class CollectingSink : public FrozenBoundarySink {
+public:
+    void add_boundary (const FrozenBoundary &b) {
+        for (int c = 0; c != b.num_contours (); ++c) {
+            for (int i = b.contour_begin (c); i != b.contour_end (c); ++i)
+                all.add_vertex (b.x ()[i], b.y ()[i], b.labels ()[i]);
+            all.end_contour ();
+        }
+    }
+
+    void merge_labels (const std::vector <int> &new_label_, int) {
+        new_label = new_label_;
+    }
+
+    FrozenBoundary all;
+    std::vector <int> new_label;
+};
+
+// streaming needs a binary PGM or PBM
+static void test_image (const std::string &filename, double threshold,
+                        bool streaming = true, bool interpolate = false) {
+    Pixmap p;
+    load_pgm (&p, filename);
+    for (int periodic = 0; periodic != 2; ++periodic)
+    for (int connect_void = 0; connect_void != 2; ++connect_void) {
+        Boundary serial;
+        marching_squares (&serial, p, threshold, connect_void, periodic, 1,
+                          interpolate);
+        // the same image with float storage
+        const Pixmap &q = p;
+        Pixmap f;
+        f.resize (q.size1 (), q.size2 ());
+        for (int j = 0; j != q.size2 (); ++j)
+        for (int i = 0; i != q.size1 (); ++i)
+            f(i,j) = q(i,j);
+        Boundary floating;
+        marching_squares (&floating, f, threshold, connect_void, periodic, 1,
+                          interpolate);
+        if (!same_boundary (serial, floating)) {
+            std::cerr << filename << ": integer and float storage differ "
+                      << "(periodic = " << periodic << ", connect_void = "
+                      << connect_void << ")\n";
+            failed = true;
+        }
+
+        const int threads[] = { 2, 3, 8, 1000 };
+        for (int i = 0; i != 4; ++i) {
+            Boundary tiled;
+            marching_squares (&tiled, p, threshold, connect_void, periodic,
+                              threads[i], interpolate);
+            if (!same_boundary (serial, tiled)) {
+                std::cerr << filename << ": tiled marching squares with "
+                          << threads[i] << " threads differs (periodic = "
+                          << periodic << ", connect_void = "
+                          << connect_void << ")\n";
+                failed = true;
+            }
+        }
+
+        for (int invert_ = 0; streaming && invert_ != 2; ++invert_) {
+            Boundary reference = serial;
+            if (invert_) {
+                Pixmap q = p;
+                invert (&q);
+                reference = Boundary ();
+                marching_squares (&reference, q, threshold, connect_void,
+                                  periodic, 1, interpolate);
+            }
+            label_none (&reference);
+            CollectingSink sink;
+            PgmRowReader reader (filename);
+            reader.invert = invert_;
+            streaming_marching_squares (&sink, &reader, threshold,
+                                        connect_void, periodic, false,
+                                        interpolate);
+            FrozenBoundary expected (reference);
+            if (canonical_contours (expected) != canonical_contours (sink.all)) {
+                std::cerr << filename << ": streaming marching squares differs "
+                          << "(periodic = " << periodic << ", connect_void = "
+                          << connect_void << ", invert = " << invert_ << ")\n";
+                failed = true;
+            }
+        }
+
+        // the components found while tracing the image in memory
+        Boundary labelled = serial;
+        int num_labels = label_by_component (&labelled);
+        // the nesting found by the sweep agrees with casting rays
+        Boundary by_rays = serial;
+        label_by_component (&by_rays, false);
+        FrozenBoundary swept_labels (labelled), ray_labels (by_rays);
+        if (!std::equal (swept_labels.labels (),
+                         swept_labels.labels () + swept_labels.num_edges (),
+                         ray_labels.labels ())) {
+            std::cerr << filename << ": component sweep differs from rays "
+                      << "(periodic = " << periodic << ", connect_void = "
+                      << connect_void << ")\n";
+            failed = true;
+        }
+        CollectingSink sink;
+        PixmapRowReader reader (p);
+        int num_components = streaming_marching_squares (
+            &sink, &reader, threshold, connect_void, periodic, true,
+            interpolate);
+        FrozenBoundary expected (labelled);
+        if (num_components != num_labels ||
+            canonical_contours (expected)
+                != canonical_contours (sink.all, sink.new_label)) {
+            std::cerr << filename << ": components differ from label_by_component "
+                      << "(periodic = " << periodic << ", connect_void = "
+                      << connect_void << ")\n";
+            failed = true;
+        }
+    }
+}
+
+// a white square with more holes than MAX_LABELS, and small components
+// below it.  the labels while streaming have to stay dense: the pieces
+// of the contours outnumber the components by far.
+static void test_many_components () {
+    const int n = 650;
+    Pixmap p;
+    p.resize (2*n + 2, 2*n + 10);
+    for (int j = 0; j != p.size2 (); ++j)
+    for (int i = 0; i != p.size1 (); ++i) {
+        bool white;
+        if (j < 2*n + 1)
+            white = i && j && i != 2*n + 1 && (i % 2 || j % 2);
+        else
+            white = j % 4 == 3 && i % 2;
+        p(i,j) = white ? 1. : 0.;
+    }
+    Boundary labelled;
+    marching_squares (&labelled, p, .5, false, false);
+    int num_labels = label_by_component (&labelled);
+    CollectingSink sink;
+    PixmapRowReader reader (p);
+    int num_components = streaming_marching_squares (
+        &sink, &reader, .5, false, false, true);
+    FrozenBoundary expected (labelled);
+    if (num_components != num_labels ||
+        (int)sink.new_label.size () != num_labels ||
+        canonical_contours (expected)
+            != canonical_contours (sink.all, sink.new_label)) {
+        std::cerr << "many components: " << num_components << " components, "
+                  << sink.new_label.size () << " preliminary labels, "
+                  << num_labels << " expected\n";
+        failed = true;
+    }
+}
+
+// compare the level set sweep against measuring the contours
+static void test_level_sets (const std::string &filename) {
+    Pixmap p;
+    load_pgm (&p, filename);
+    const double t[] = { .5, 0., .3, .95, .7, 1. };
+    std::vector <double> thresholds (t, t + sizeof (t) / sizeof (*t));
+    for (int periodic = 0; periodic != 2; ++periodic)
+    for (int connect_void = 0; connect_void != 2; ++connect_void) {
+        std::vector <level_set_t> sweep;
+        level_set_sweep (&sweep, p, thresholds, connect_void, periodic);
+        for (int t = 0; t != (int)thresholds.size (); ++t) {
+            Boundary b;
+            marching_squares (&b, p, thresholds[t], connect_void, periodic);
+            FrozenBoundary f (b);
+            double area = 0., perimeter = 0.;
+            int euler = 0;
+            for (int c = 0; c != f.num_contours (); ++c) {
+                double contour_area = 0.;
+                for (int i = f.contour_begin (c); i != f.contour_end (c); ++i) {
+                    int j = i+1 == f.contour_end (c) ? f.contour_begin (c) : i+1;
+                    contour_area += .5 * (f.x ()[i] * f.y ()[j] - f.x ()[j] * f.y ()[i]);
+                    perimeter += hypot (f.x ()[j] - f.x ()[i], f.y ()[j] - f.y ()[i]);
+                }
+                area += contour_area;
+                euler += contour_area > 0. ? 1 : -1;
+            }
+            if (fabs (area - sweep[t].area) > 1e-6 ||
+                fabs (perimeter - sweep[t].perimeter) > 1e-6 ||
+                euler != sweep[t].euler || sweep[t].threshold != thresholds[t]) {
+                std::cerr << filename << ": level set sweep differs at threshold "
+                          << thresholds[t] << " (periodic = " << periodic
+                          << ", connect_void = " << connect_void << ")\n";
+                failed = true;
+            }
+        }
+    }
+}
+
+int main () {
+    std::cerr << "Testing tiled and streaming marching squares...\n";
+    test_image ("ma105_7o_cropped.pgm", .95);
+    test_image ("ma105_7o_cropped.pgm", .5);
+    test_image ("slika.pgm", .5);
+    test_image ("periodicblobs.pgm", .5, false);
+    test_image ("kartoffel.pgm", .5);
+    test_image ("pgmreader_test_in/odd/test-1b-bin.pbm", .5);
+    test_image ("pgmreader_test_in/odd/test-16b-bin.pgm", .5);
+    test_image ("ma105_7o_cropped.pgm", .95, true, true);
+    test_many_components ();
+    std::cerr << "Testing the level set sweep...\n";
+    test_level_sets ("ma105_7o_cropped.pgm");
+    test_level_sets ("periodicblobs.pgm");
+    test_level_sets ("pgmreader_test_in/odd/test-16b-bin.pgm");
+    return int (failed);
+}
@@ -3,53 +3,36 @@
 #include <iostream>
 #include "../util.h"
 
-int main (int argc, char **argv) {
+static bool failed = false;
 
-    bool failed = false;
+// the ASCII file, parsed in num_threads pieces, has to agree with
+// the binary one
+static void compare (const std::string &name, const std::string &suffix,
+                     int num_threads) {
     Pixmap ascii, binary;
-
-    std::cerr << "Testing PGM reader...\n";
-
-    load_pgm (&ascii, "pgmreader_test_in/odd/test-16b-ascii.pgm");
-    load_pgm (&binary, "pgmreader_test_in/odd/test-16b-bin.pgm");
-    if (! (ascii == binary)) {
-        std::cerr << "pgmreader_test_in/odd/test-16b: ascii / binary mismatch\n";
-        failed = true;
-    }
-
-    load_pgm (&ascii, "pgmreader_test_in/odd/test-8b-ascii.pgm");
-    load_pgm (&binary, "pgmreader_test_in/odd/test-8b-bin.pgm");
-    if (! (ascii == binary)) {
-        std::cerr << "pgmreader_test_in/odd/test-8b: ascii / binary mismatch\n";
-        failed = true;
-    }
-
-    load_pgm (&ascii, "pgmreader_test_in/odd/test-1b-ascii.pbm");
-    load_pgm (&binary, "pgmreader_test_in/odd/test-1b-bin.pbm");
+    load_pgm (&ascii, "pgmreader_test_in/" + name + "-ascii." + suffix,
+              num_threads);
+    load_pgm (&binary, "pgmreader_test_in/" + name + "-bin." + suffix);
     if (! (ascii == binary)) {
-        std::cerr << "pgmreader_test_in/odd/test-1b: ascii / binary mismatch\n";
+        std::cerr << "pgmreader_test_in/" << name << ": ascii / binary mismatch";
+        if (num_threads > 1)
+            std::cerr << " (" << num_threads << " threads)";
+        std::cerr << "\n";
         failed = true;
     }
+}
 
-    load_pgm (&ascii, "pgmreader_test_in/even/test-16b-ascii.pgm");
-    load_pgm (&binary, "pgmreader_test_in/even/test-16b-bin.pgm");
-    if (! (ascii == binary)) {
-        std::cerr << "pgmreader_test_in/even/test-16b: ascii / binary mismatch\n";
-        failed = true;
-    }
+int main (int argc, char **argv) {
 
-    load_pgm (&ascii, "pgmreader_test_in/even/test-8b-ascii.pgm");
-    load_pgm (&binary, "pgmreader_test_in/even/test-8b-bin.pgm");
-    if (! (ascii == binary)) {
-        std::cerr << "pgmreader_test_in/even/test-8b: ascii / binary mismatch\n";
-        failed = true;
-    }
+    std::cerr << "Testing PGM reader...\n";
 
-    load_pgm (&ascii, "pgmreader_test_in/even/test-1b-ascii.pbm");
-    load_pgm (&binary, "pgmreader_test_in/even/test-1b-bin.pbm");
-    if (! (ascii == binary)) {
-        std::cerr << "pgmreader_test_in/even/test-1b: ascii / binary mismatch\n";
-        failed = true;
+    for (int threads = 1; threads <= 7; threads += 6) {
+        compare ("odd/test-16b", "pgm", threads);
+        compare ("odd/test-8b", "pgm", threads);
+        compare ("odd/test-1b", "pbm", threads);
+        compare ("even/test-16b", "pgm", threads);
+        compare ("even/test-8b", "pgm", threads);
+        compare ("even/test-1b", "pbm", threads);
     }
 
     return int (failed);
@@ -185,6 +185,12 @@ int Configuration::integer (const string_t &section, const string_t &key) const
     return x;
 }
 
+int Configuration::integer (const string_t &section, const string_t &key, int default_) const {
+    if (string (section, key, "") == "")
+        return default_;
+    return integer (section, key);
+}
+
 double Configuration::floating (const string_t &section, const string_t &key) const {
     string_t v = value (section, key);
     errno = 0;
@@ -22,6 +22,7 @@ public:
     bool    boolean (const string_t &section, const string_t &key) const;
     bool    boolean (const string_t &section, const string_t &key, bool default_) const;
     int     integer (const string_t &section, const string_t &key) const;
+    int     integer (const string_t &section, const string_t &key, int default_) const;
     double floating (const string_t &section, const string_t &key) const;
 
 #ifndef NDEBUG
@@ -6,45 +6,179 @@
 #include <stdarg.h>
 #include <string.h>
 #include <iomanip>
+#include <iterator>
+#include <stdexcept>
+#include <fcntl.h>
+#include <unistd.h>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <pthread.h>
 
 static const double VERTEX_MERGE_TOLERANCE = 1e-6;
 
 
+// whether die () throws is a property of the calling thread, so that the
+// batch mode and the library don't change it for anyone else.
+static pthread_key_t die_throws_key;
+static pthread_once_t die_throws_once = PTHREAD_ONCE_INIT;
+
+static void create_die_throws_key () {
+    pthread_key_create (&die_throws_key, 0);
+}
+
+bool die_throws () {
+    pthread_once (&die_throws_once, create_die_throws_key);
+    return pthread_getspecific (die_throws_key) != 0;
+}
+
+DieThrows::DieThrows (bool on)
+    : my_prev (die_throws ()) {
+    pthread_setspecific (die_throws_key, on ? &die_throws_key : 0);
+}
+
+DieThrows::~DieThrows () {
+    pthread_setspecific (die_throws_key, my_prev ? &die_throws_key : 0);
+}
+
 void die (const char *fmt, ...) {
+    char msg[1024];
     va_list al;
     va_start (al, fmt);
-    vfprintf (stderr, fmt, al);
+    vsnprintf (msg, sizeof (msg), fmt, al);
+    va_end (al);
+    if (die_throws ())
+        throw std::runtime_error (msg);
+    fputs (msg, stderr);
     fputs ("\n", stderr);
     abort ();
 }
 
 Pixmap::Pixmap ()
-    : my_xdim (0), my_ydim (0) { }
+    : my_storage (FLOAT), my_row_bytes (0), my_max_raw (0), my_nrml (0.),
+      my_xdim (0), my_ydim (0) { }
 
 void Pixmap::resize (int dimx, int dimy) {
+    my_storage = FLOAT;
+    my_row_bytes = 0;
+    my_max_raw = 0;
+    my_nrml = 0.;
+    my_bytes.clear ();
+    my_words.clear ();
     my_data.resize ((my_xdim = dimx) * (my_ydim = dimy));
 }
 
+void Pixmap::resize_raw (int dimx, int dimy, long max_raw) {
+    assert (max_raw > 0);
+    if (max_raw > 65535)
+        die ("Pixmap: raw values up to %li cannot be stored", max_raw);
+    my_max_raw = max_raw;
+    my_nrml = 1. / max_raw;
+    my_data.clear ();
+    my_bytes.clear ();
+    my_words.clear ();
+    const int n = (my_xdim = dimx) * (my_ydim = dimy);
+    if (max_raw == 1) {
+        my_storage = BIT;
+        my_row_bytes = (dimx + 7) / 8;
+        my_bytes.resize (my_row_bytes * dimy);
+    } else if (max_raw < 256) {
+        my_storage = UINT8;
+        my_row_bytes = dimx;
+        my_bytes.resize (n);
+    } else {
+        my_storage = UINT16;
+        my_row_bytes = 2 * dimx;
+        my_words.resize (n);
+    }
+}
+
+void *Pixmap::raw_row (int y) {
+    assert (y >= 0 && y < my_ydim);
+    switch (my_storage) {
+    case UINT8:
+    case BIT:
+        return &my_bytes[y * my_row_bytes];
+    case UINT16:
+        return &my_words[y * my_xdim];
+    default:
+        die ("Pixmap::raw_row: no integer storage");
+        return 0;
+    }
+}
+
 void Pixmap::init_zero () {
-    memset ((void *)(&my_data[0]), 0, sizeof (val_t) * my_data.size ());
+    std::fill (my_data.begin (), my_data.end (), val_t (0.));
+    std::fill (my_bytes.begin (), my_bytes.end (), 0);
+    std::fill (my_words.begin (), my_words.end (), 0);
+}
+
+long Pixmap::raw_threshold (val_t t) const {
+    assert (my_storage != FLOAT);
+    // start from the exact value, and correct for the rounding of
+    // scale_raw
+    long ret = std::max (-1L, std::min (my_max_raw, long (floor (t * my_max_raw))));
+    while (ret < my_max_raw && !(scale_raw (ret+1) > t))
+        ++ret;
+    while (ret >= 0 && scale_raw (ret) > t)
+        --ret;
+    return ret;
 }
 
+// the values have to agree, not the way they are stored
 bool operator== (const Pixmap &a, const Pixmap &b) {
-    return a.my_xdim == b.my_xdim && a.my_ydim == b.my_ydim &&
-        0 == memcmp ((void *)(&a.my_data[0]), (void *)(&b.my_data[0]),
-                     sizeof (Pixmap::val_t) * a.my_data.size ());
+    if (a.my_xdim != b.my_xdim || a.my_ydim != b.my_ydim)
+        return false;
+    for (int y = 0; y != a.my_ydim; ++y)
+    for (int x = 0; x != a.my_xdim; ++x)
+        if (a(x,y) != b(x,y))
+            return false;
+    return true;
+}
+
+MappedFile::MappedFile (const std::string &filename)
+    : my_map (MAP_FAILED), my_size (0), my_data (0) {
+    int fd = open (filename.c_str (), O_RDONLY);
+    struct stat st;
+    if (fd == -1 || fstat (fd, &st) != 0) {
+        if (fd != -1)
+            close (fd);
+        throw std::runtime_error ("Cannot open \"" + filename + "\"");
+    }
+    if (S_ISREG (st.st_mode) && st.st_size > 0) {
+        my_size = st.st_size;
+        my_map = mmap (0, my_size, PROT_READ, MAP_PRIVATE, fd, 0);
+    }
+    close (fd);
+    if (my_map != MAP_FAILED) {
+        my_data = (const char *)my_map;
+        return;
+    }
+    std::ifstream is (filename.c_str (), std::ios::in | std::ios::binary);
+    is.exceptions (std::ios::badbit);
+    my_copy.assign (std::istreambuf_iterator <char> (is),
+                    std::istreambuf_iterator <char> ());
+    my_size = my_copy.size ();
+    my_data = my_copy.empty () ? 0 : &my_copy[0];
+}
+
+MappedFile::~MappedFile () {
+    if (my_map != MAP_FAILED)
+        munmap (my_map, my_size);
 }
 
-Boundary::Boundary () {
+Boundary::Boundary ()
+    : my_geometry_cached (false), my_geometry_filled (false) {
 }
 
 int Boundary::insert_vertex (const vec_t &v) {
+    drop_geometry_cache_ ();
     int ret = my_vert.size ();
     my_vert.push_back (v);
     return ret;
 }
 
 int Boundary::insert_edge (int a, int b, int c, int d) {
+    drop_geometry_cache_ ();
     int ret = my_edge.size ();
     // look up missing arguments
     if (c == INVALID_VERTEX) {
@@ -137,6 +271,7 @@ static void assert_boundary (const Boundary &b) {
 Boundary::edge_iterator Boundary::remove_vertex1 (edge_iterator eit) {
     assert (this == eit.my_boundary);
     assert (eit->next != INVALID_EDGE);
+    drop_geometry_cache_ ();
     // normally, delete the next edge.
     // if that edge is the magic edge which gives the name to this contour,
     // delete this edge instead.
@@ -187,6 +322,7 @@ inline void Boundary::take_edge_out (int ed) {
 }
 
 void Boundary::split_edge (edge_iterator eit, const vec_t &newv) {
+    drop_geometry_cache_ ();
     int nedge_id = my_edge.size ();
     int nvert_id = insert_vertex (newv);
     edge_t E = *eit;
@@ -375,12 +511,24 @@ std::string Boundary::edge_iterator::to_string () const {
 }
 
 double Boundary::edge_length (Boundary::edge_iterator it) const {
+    if (my_geometry_cached) {
+        fill_geometry_cache ();
+        return my_edge_length[it.my_position];
+    }
+    return edge_length_ (it);
+}
+
+double Boundary::edge_length_ (Boundary::edge_iterator it) const {
     vec_t dist = vertex(it->vert0);
     dist -= vertex(it->vert1);
     return dist.norm ();
 }
 
 double Boundary::inflection_after_edge (Boundary::edge_iterator it) const {
+    if (my_geometry_cached) {
+        fill_geometry_cache ();
+        return my_edge_inflection[it.my_position];
+    }
     // normalized tangent vectors
     vec_t tang0 = vertex(it->vert1);
     tang0 -= vertex(it->vert0);
@@ -422,6 +570,14 @@ double Boundary::inflection_after_edge (Boundary::edge_iterator it) const {
 }
 
 Boundary::vec_t Boundary::edge_tangent (Boundary::edge_iterator it) const {
+    if (my_geometry_cached) {
+        fill_geometry_cache ();
+        return my_edge_tangent[it.my_position];
+    }
+    return edge_tangent_ (it);
+}
+
+Boundary::vec_t Boundary::edge_tangent_ (Boundary::edge_iterator it) const {
     vec_t ret = vertex(it->vert1);
     ret -= vertex(it->vert0);
     ret /= ret.norm ();
@@ -429,12 +585,46 @@ Boundary::vec_t Boundary::edge_tangent (Boundary::edge_iterator it) const {
 }
 
 Boundary::vec_t Boundary::edge_normal (Boundary::edge_iterator it) const {
+    if (my_geometry_cached) {
+        fill_geometry_cache ();
+        const vec_t &tang = my_edge_tangent[it.my_position];
+        return vec_t (tang[1], -tang[0]);
+    }
     vec_t tmp = vertex(it->vert1);
     tmp -= vertex(it->vert0);
     tmp /= tmp.norm ();
     return vec_t (tmp[1], -tmp[0]);
 }
 
+void Boundary::cache_geometry () {
+    assert_complete_boundary (*this);
+    my_geometry_cached = true;
+}
+
+void Boundary::fill_geometry_cache () const {
+    if (!my_geometry_cached || my_geometry_filled)
+        return;
+    my_edge_length.resize (my_edge.size ());
+    my_edge_tangent.resize (my_edge.size ());
+    my_edge_inflection.resize (my_edge.size ());
+    contour_iterator cit;
+    edge_iterator eit;
+    for (cit = contours_begin (); cit != contours_end (); ++cit)
+    for (eit = edges_begin (cit); eit != edges_end (cit); ++eit) {
+        my_edge_length[eit.my_position] = edge_length_ (eit);
+        my_edge_tangent[eit.my_position] = edge_tangent_ (eit);
+    }
+    // same computation as inflection_after_edge, from the cached tangents
+    for (cit = contours_begin (); cit != contours_end (); ++cit)
+    for (eit = edges_begin (cit); eit != edges_end (cit); ++eit) {
+        double ret = inflection_angle (my_edge_tangent[eit.my_position],
+                                       my_edge_tangent[eit->next]);
+        assert_not_nan (ret);
+        my_edge_inflection[eit.my_position] = ret;
+    }
+    my_geometry_filled = true;
+}
+
 Boundary::vec_t Boundary::edge_vertex0 (Boundary::edge_iterator it) const {
     return vertex (it->vert0);
 }
@@ -531,7 +721,45 @@ void Boundary::fix_contours (bool silent) {
     assert_boundary (*this);
 }
 
+void FrozenBoundary::freeze (const Boundary &b) {
+    assert_complete_boundary (b);
+    clear ();
+    my_offset.clear ();
+    my_x.reserve (b.num_edges ());
+    my_y.reserve (b.num_edges ());
+    my_label.reserve (b.num_edges ());
+    my_offset.reserve (b.num_contours () + 1);
+    const bool geometry = b.geometry_is_cached ();
+    if (geometry) {
+        b.fill_geometry_cache ();
+        my_length.reserve (b.num_edges ());
+        my_tangent_x.reserve (b.num_edges ());
+        my_tangent_y.reserve (b.num_edges ());
+        my_inflection.reserve (b.num_edges ());
+    }
+    Boundary::contour_iterator cit;
+    Boundary::edge_iterator eit;
+    for (cit = b.contours_begin (); cit != b.contours_end (); ++cit) {
+        my_offset.push_back ((int)my_x.size ());
+        for (eit = b.edges_begin (cit); eit != b.edges_end (cit); ++eit) {
+            const vec_t &v = b.vertex (eit->vert0);
+            my_x.push_back (v[0]);
+            my_y.push_back (v[1]);
+            my_label.push_back (eit->label);
+            if (geometry) {
+                const vec_t t = b.edge_tangent (eit);
+                my_length.push_back (b.edge_length (eit));
+                my_tangent_x.push_back (t[0]);
+                my_tangent_y.push_back (t[1]);
+                my_inflection.push_back (b.inflection_after_edge (eit));
+            }
+        }
+    }
+    my_offset.push_back ((int)my_x.size ());
+}
+
 void Boundary::reverse_contour (Boundary::contour_iterator cit) {
+    drop_geometry_cache_ ();
     edge_iterator eit     = edges_begin (cit);
     edge_iterator eit_end = edges_end (cit);
     for (; eit != eit_end; ++eit) {
@@ -704,6 +932,13 @@ void dump_contours (std::ostream &os, const Boundary &a, int flags) {
 }
 
 void invert (Pixmap *p) {
+    // integer values are inverted on their own scale, which is exact
+    if (p->storage () != Pixmap::FLOAT) {
+        for (int y = 0; y != p->size2 (); ++y)
+        for (int x = 0; x != p->size1 (); ++x)
+            p->set_raw (x, y, p->max_raw () - p->raw (x, y));
+        return;
+    }
     Pixmap::val_t off = p->max_val () - p->min_val ();
     for (int y = 0; y != p->size2 (); ++y)
     for (int x = 0; x != p->size1 (); ++x)
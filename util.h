@@ -9,6 +9,7 @@
 #include <algorithm>
 #include <vector>
 #include <ostream>
+#include <fstream>
 #include <math.h>
 #include "tensor.h"
 
@@ -20,6 +21,20 @@
 
 void no_return never_reached ();
 void no_return die (const char *fmt, ...);
+// while a DieThrows lives, die () throws a std::runtime_error with the
+// message instead of aborting, in the thread which created it.  papaya's
+// batch mode uses this to carry on with the next input.
+class DieThrows {
+public:
+    explicit DieThrows (bool on = true);
+    ~DieThrows ();
+
+private:
+    DieThrows (const DieThrows &);
+    DieThrows &operator= (const DieThrows &);
+    bool my_prev;
+};
+bool die_throws ();
 
 struct rect_t {
     double left, right;
@@ -46,6 +61,11 @@ struct EigenSystem {
 vec_t rot90_ccw (const vec_t &);
 vec_t rot90_cw (const vec_t &);
 
+// angle between two unit tangent vectors,
+// in radians, in range [-pi, pi]
+// positive means turning counterclockwise (convex for outer boundaries)
+double inflection_angle (const vec_t &tang0, const vec_t &tang1);
+
 
 // return dyadic product  lhs (tensor) rhs in out,
 // as a 2x2 matrix.
@@ -62,7 +82,12 @@ class Pixmap {
 public:
     Pixmap ();
 
+    // float storage, for any values
     void resize (int dimx, int dimy);
+    // integer storage of the raw values 0...max_raw, which are scaled
+    // to min_val ()...max_val () when read.  uses 1 bit per pixel for
+    // max_raw == 1, 8 bits up to 255, and 16 bits up to 65535.
+    void resize_raw (int dimx, int dimy, long max_raw);
     int size1 () const;
     int size2 () const;
     void init_zero ();
@@ -71,22 +96,115 @@ public:
     static val_t min_val () { return 0.; }
     static val_t max_val () { return 1.; }
 
+    enum storage_t { FLOAT, UINT8, UINT16, BIT };
+    storage_t storage () const { return my_storage; }
+    long max_raw () const { return my_max_raw; }
+
     // x is running from left to right
     // y from top to bottom
+    // the reference is only available with float storage
     val_t &operator() (int x, int y);
-    const val_t &operator() (int x, int y) const;
+    val_t operator() (int x, int y) const;
+
+    // the raw values, with integer storage only
+    long raw (int x, int y) const;
+    // row y of the integer storage, for filling it in bulk: one byte
+    // per pixel up to max_raw () == 255, two bytes (unsigned short) up
+    // to 65535.  bits are stored like in PBM files, most significant
+    // bit first and rows padded to whole bytes, but 1 means white.
+    void *raw_row (int y);
+    void set_raw (int x, int y, long value);
+    val_t scale_raw (long value) const;
+    // the largest raw value which is not greater than t when scaled,
+    // or -1.  comparing the raw values against it is the same as
+    // comparing the scaled values against t.
+    long raw_threshold (val_t t) const;
 
     friend bool operator== (const Pixmap &, const Pixmap &);
 
 private:
+    int index (int x, int y) const;
     std::vector <val_t> my_data;
+    std::vector <unsigned char> my_bytes;
+    std::vector <unsigned short> my_words;
+    storage_t my_storage;
+    int my_row_bytes;
+    long my_max_raw;
+    double my_nrml;
     int my_xdim, my_ydim;
 };
 
-void load_pgm (Pixmap *, const std::string &pgmfilename);
+// ASCII files are parsed in num_threads pieces
+void load_pgm (Pixmap *, const std::string &pgmfilename, int num_threads = 1);
 void write_pgm (const std::string &filename, const Pixmap &);
 void invert (Pixmap *);
 
+// the contents of a whole file.  regular files are mapped into memory,
+// anything else (e.g. a pipe) is read in one go.
+class MappedFile {
+public:
+    explicit MappedFile (const std::string &filename);
+    ~MappedFile ();
+    const char *data () const { return my_data; }
+    long size () const { return my_size; }
+
+private:
+    MappedFile (const MappedFile &);
+    void *my_map;
+    long my_size;
+    std::vector <char> my_copy;
+    const char *my_data;
+};
+
+// an image which is read one row at a time
+class PixmapRowSource {
+public:
+    virtual ~PixmapRowSource () { }
+    virtual int size1 () const = 0;
+    virtual int size2 () const = 0;
+    // read row j into row[0...size1()-1]
+    virtual void read_row (int j, Pixmap::val_t *row) = 0;
+};
+
+// the rows of a Pixmap in memory
+class PixmapRowReader : public PixmapRowSource {
+public:
+    explicit PixmapRowReader (const Pixmap &p) : my_p (p) { }
+
+    int size1 () const;
+    int size2 () const;
+    void read_row (int j, Pixmap::val_t *row);
+
+private:
+    const Pixmap &my_p;
+};
+
+// read a binary PGM (P5) or PBM (P4) file one row at a time, so that
+// the image never has to fit into memory.  rows can be read in any
+// order, but reading them in sequence avoids seeking.
+class PgmRowReader : public PixmapRowSource {
+public:
+    explicit PgmRowReader (const std::string &pgmfilename);
+
+    int size1 () const;
+    int size2 () const;
+    // read row j into row[0...size1()-1], scaled like load_pgm does
+    void read_row (int j, Pixmap::val_t *row);
+
+    // invert the values as they are read, like invert (Pixmap *)
+    bool invert;
+
+private:
+    PgmRowReader (const PgmRowReader &);
+    std::ifstream my_is;
+    int my_xdim, my_ydim;
+    long my_max_value;
+    int my_bits, my_row_bytes;
+    std::streampos my_data_start;
+    int my_next_row;
+    std::vector <unsigned char> my_buffer;
+};
+
 
 //
 // data structure & toolbox for boundaries
@@ -191,6 +309,18 @@ public:
     bool edge_has_predecessor (edge_iterator) const;
     bool contour_is_complete (contour_iterator) const;
 
+    // cache the per-edge geometry (length, unit tangent, inflection
+    // after the edge) in flat arrays indexed by edge.
+    // the arrays are filled on the first call to edge_length etc.,
+    // which then become lookups.  any modification of the boundary
+    // drops the cache; call cache_geometry again when done modifying.
+    // expects that all contours are complete.
+    // filling the cache is not thread-safe; call fill_geometry_cache
+    // before sharing the boundary between threads.
+    void cache_geometry ();
+    bool geometry_is_cached () const;
+    void fill_geometry_cache () const;
+
     // reverse the direction of a contour
     // expects that the contour is complete (i.e. closed)
     void reverse_contour (contour_iterator);
@@ -239,27 +369,144 @@ private:
     void assert_valid_link_structure_helper_ (int) const;
     void set_contour_id_ (edge_iterator, edge_iterator, int);
     void open_link_ (edge_iterator);
+    void drop_geometry_cache_ ();
+    // uncached versions of edge_length, edge_tangent
+    double edge_length_ (edge_iterator) const;
+    vec_t edge_tangent_ (edge_iterator) const;
 
     edge_iterator edges_begin (int) const;
     edge_iterator edges_end (int) const;
     std::vector <vec_t> my_vert;
     std::vector <edge_t> my_edge;
     std::vector <int> my_contours;
+    // geometry cache, see cache_geometry
+    bool my_geometry_cached;
+    mutable bool my_geometry_filled;
+    mutable std::vector <double> my_edge_length;
+    mutable std::vector <vec_t> my_edge_tangent;
+    mutable std::vector <double> my_edge_inflection;
     friend void fix_contours (Boundary *, bool silent);
     void fix_contours (bool silent);
 };
 
+//
+// compacted, read-only copy of a complete Boundary.
+// the vertices of each contour are stored contiguously and in
+// traversal order, as separate x and y arrays.  contour c occupies
+// the index range [contour_begin (c), contour_end (c)).
+// edge i runs from vertex i to vertex i+1, wrapping around to
+// contour_begin at the end of the contour, and carries label (i).
+// if the Boundary caches its geometry, the lengths, tangents and
+// inflections (after each edge) are copied as well, so that they are
+// not computed once more.
+//
+class FrozenBoundary {
+public:
+    FrozenBoundary ();
+    explicit FrozenBoundary (const Boundary &);
+    void freeze (const Boundary &);
+
+    int num_contours () const;
+    int num_edges () const;
+    int contour_begin (int) const;
+    int contour_end (int) const;
+
+    // flat arrays, one entry per edge
+    const double *x () const;
+    const double *y () const;
+    const int *labels () const;
+    // the geometry from the cache of the Boundary, or NULL
+    bool has_geometry () const;
+    const double *lengths () const;
+    const double *tangent_x () const;
+    const double *tangent_y () const;
+    const double *inflections () const;
+
+    // build up contours one vertex at a time.  each vertex starts
+    // an edge carrying the given label.
+    void clear ();
+    void add_vertex (double x, double y, int label);
+    void end_contour ();
+
+private:
+    std::vector <double> my_x, my_y;
+    std::vector <int> my_label;
+    std::vector <double> my_length, my_tangent_x, my_tangent_y;
+    std::vector <double> my_inflection;
+    // start of each contour, plus one past the end of the last
+    std::vector <int> my_offset;
+};
+
+// with num_threads > 1, the image is cut into horizontal bands which are
+// traced in parallel.  the result is the same.
+// with interpolate, the vertices are placed where the linear interpolation
+// between the two pixels crosses the threshold, instead of halfway.
 void marching_squares (Boundary *, const Pixmap &,
                        Pixmap::val_t threshold,
-                       bool connect_void, bool periodic_data);
+                       bool connect_void, bool periodic_data,
+                       int num_threads = 1, bool interpolate = false);
+
+// area, perimeter and Euler characteristic of the white phase, as seen
+// by marching_squares at one threshold
+struct level_set_t {
+    double threshold;
+    double area, perimeter;
+    int euler;
+};
+
+// level_set_t for many thresholds at once.  with the vertices at the
+// midpoints of the pixel edges, each square of the dual lattice adds a
+// fixed amount to these, depending only on its type.  the pixels are
+// sorted by value and turned white one after the other, updating the
+// squares around them; so the cost hardly depends on the number of
+// thresholds.  the results are in the order of the thresholds.
+void level_set_sweep (std::vector <level_set_t> *, const Pixmap &,
+                      const std::vector <double> &thresholds,
+                      bool connect_void, bool periodic_data);
+
+// receives the contours found by streaming_marching_squares, in batches
+class FrozenBoundarySink {
+public:
+    virtual ~FrozenBoundarySink () { }
+    virtual void add_boundary (const FrozenBoundary &) = 0;
+    // called once at the end when labelling by component: label l of
+    // the contours handed over so far is to be read as new_label[l].
+    virtual void merge_labels (const std::vector <int> &new_label,
+                               int num_labels) = 0;
+};
+
+// marching squares on an image which is read row by row.  only two rows
+// of pixels and the open contours are kept in memory; the contours are
+// handed to the sink once they are closed.  the contours are the same as
+// those of marching_squares, but in a different order and starting at
+// different vertices.
+// without by_component, all contours get label 0.  with by_component,
+// they get preliminary labels, which are mapped to the labels of
+// label_by_component by a final call to sink->merge_labels.  returns the
+// number of labels.
+int streaming_marching_squares (FrozenBoundarySink *, PixmapRowSource *,
+                                Pixmap::val_t threshold,
+                                bool connect_void, bool periodic_data,
+                                bool by_component = false,
+                                bool interpolate = false);
 void dump_contours (std::ostream &, const Boundary &, int flags = 0);
 void dump_contours (const std::string & filename, const Boundary &, int flags = 0);
-void load_poly (class Boundary *, const std::string &polyfilename);
+// with several threads, the POINTS are parsed in parallel; every vertex
+// has to be on a line of its own then.
+void load_poly (class Boundary *, const std::string &polyfilename,
+                int num_threads = 1);
+// binary polygon files, see the README.  the labels are stored if
+// with_labels is set, and restored if the file has them.
+void save_bpoly (const std::string &filename, const class Boundary &,
+                 bool with_labels = false, bool single_precision = false);
+void load_bpoly (class Boundary *, const std::string &filename);
 
 // labelling
 int  label_none (Boundary *);
 int  label_by_contour_index (Boundary *);
-int  label_by_component (Boundary *);
+// the cavities are assigned to their components by a plane sweep, or if
+// by_sweep is false or the contours do not nest properly, by casting rays.
+int  label_by_component (Boundary *, bool by_sweep = true);
 int  label_by_domain (Boundary *b, const rect_t &bbox, int divx, int divy);
 int  label_by_domain (Boundary *b, const rect_t &bbox, int divx, int divy, bool for_w0);
 vec2_t label_domain_center (int label, const rect_t &bbox, int divx, int divy);
@@ -310,12 +557,7 @@ inline int Pixmap::size2 () const {
     return my_ydim;
 }
 
-inline Pixmap::val_t &Pixmap::operator() (int x, int y) {
-    const Pixmap *this_ = this;
-    return const_cast <val_t &> ((*this_)(x, y));
-}
-
-inline const Pixmap::val_t &Pixmap::operator() (int x, int y) const {
+inline int Pixmap::index (int x, int y) const {
 #ifndef NDEBUG
     if (x < 0 || x >= my_xdim) {
         die ("invalid x coordinate %i [0:%i)", x, my_xdim);
@@ -323,7 +565,58 @@ inline const Pixmap::val_t &Pixmap::operator() (int x, int y) const {
         die ("invalid y coordinate %i [0:%i)", y, my_ydim);
     }
 #endif
-    return my_data[y * my_xdim + x];
+    return y * my_xdim + x;
+}
+
+inline Pixmap::val_t &Pixmap::operator() (int x, int y) {
+    assert (my_storage == FLOAT);
+    return my_data[index (x, y)];
+}
+
+inline Pixmap::val_t Pixmap::operator() (int x, int y) const {
+    if (my_storage == FLOAT)
+        return my_data[index (x, y)];
+    return scale_raw (raw (x, y));
+}
+
+inline long Pixmap::raw (int x, int y) const {
+    const int i = index (x, y);
+    switch (my_storage) {
+    case UINT8:
+        return my_bytes[i];
+    case UINT16:
+        return my_words[i];
+    case BIT:
+        return (my_bytes[y * my_row_bytes + x/8] >> (7 - x%8)) & 1;
+    default:
+        die ("Pixmap::raw: no integer storage");
+        return 0;
+    }
+}
+
+inline void Pixmap::set_raw (int x, int y, long value) {
+    assert (value >= 0 && value <= my_max_raw);
+    const int i = index (x, y);
+    switch (my_storage) {
+    case UINT8:
+        my_bytes[i] = (unsigned char)value;
+        break;
+    case UINT16:
+        my_words[i] = (unsigned short)value;
+        break;
+    case BIT:
+        if (value)
+            my_bytes[y * my_row_bytes + x/8] |= (unsigned char)(0x80 >> (x%8));
+        else
+            my_bytes[y * my_row_bytes + x/8] &= (unsigned char)~(0x80 >> (x%8));
+        break;
+    default:
+        die ("Pixmap::set_raw: no integer storage");
+    }
+}
+
+inline Pixmap::val_t Pixmap::scale_raw (long value) const {
+    return val_t (value * my_nrml);
 }
 
 inline const Boundary::vec_t &Boundary::vertex (int i) const {
@@ -335,6 +628,19 @@ inline const Boundary::vec_t &Boundary::vertex (int i) const {
 #endif
 }
 
+inline bool Boundary::geometry_is_cached () const {
+    return my_geometry_cached;
+}
+
+inline void Boundary::drop_geometry_cache_ () {
+    if (my_geometry_cached) {
+        my_geometry_cached = my_geometry_filled = false;
+        my_edge_length.clear ();
+        my_edge_tangent.clear ();
+        my_edge_inflection.clear ();
+    }
+}
+
 inline int Boundary::insert_vertex (double x, double y) {
     return insert_vertex (vec_t (x, y));
 }
@@ -416,6 +722,13 @@ inline const Boundary::edge_t *Boundary::edge_iterator::operator-> () const {
     return &(operator* ());
 }
 
+inline double inflection_angle (const vec_t &tang0, const vec_t &tang1) {
+    // z component of cross prod.
+    double sinphi = tang0[0] * tang1[1] - tang1[0] * tang0[1];
+    double cosphi = dot (tang0, tang1);
+    return atan2 (sinphi, cosphi);
+}
+
 inline double Boundary::inflection_before_edge (Boundary::edge_iterator it) const {
     --it;
     return inflection_after_edge (it);
@@ -442,6 +755,96 @@ inline Boundary::edge_t &Boundary::edge (edge_iterator eit) {
     return edge(eit.my_position);
 }
 
+inline FrozenBoundary::FrozenBoundary () {
+    my_offset.push_back (0);
+}
+
+inline FrozenBoundary::FrozenBoundary (const Boundary &b) {
+    freeze (b);
+}
+
+inline int FrozenBoundary::num_contours () const {
+    return (int)my_offset.size () - 1;
+}
+
+inline int FrozenBoundary::num_edges () const {
+    return (int)my_x.size ();
+}
+
+inline int FrozenBoundary::contour_begin (int c) const {
+    return my_offset[c];
+}
+
+inline int FrozenBoundary::contour_end (int c) const {
+    return my_offset[c+1];
+}
+
+inline const double *FrozenBoundary::x () const {
+    return my_x.empty () ? 0 : &my_x[0];
+}
+
+inline const double *FrozenBoundary::y () const {
+    return my_y.empty () ? 0 : &my_y[0];
+}
+
+inline const int *FrozenBoundary::labels () const {
+    return my_label.empty () ? 0 : &my_label[0];
+}
+
+inline bool FrozenBoundary::has_geometry () const {
+    return !my_length.empty ();
+}
+
+inline const double *FrozenBoundary::lengths () const {
+    return my_length.empty () ? 0 : &my_length[0];
+}
+
+inline const double *FrozenBoundary::tangent_x () const {
+    return my_tangent_x.empty () ? 0 : &my_tangent_x[0];
+}
+
+inline const double *FrozenBoundary::tangent_y () const {
+    return my_tangent_y.empty () ? 0 : &my_tangent_y[0];
+}
+
+inline const double *FrozenBoundary::inflections () const {
+    return my_inflection.empty () ? 0 : &my_inflection[0];
+}
+
+inline void FrozenBoundary::clear () {
+    my_x.clear ();
+    my_y.clear ();
+    my_label.clear ();
+    my_length.clear ();
+    my_tangent_x.clear ();
+    my_tangent_y.clear ();
+    my_inflection.clear ();
+    my_offset.assign (1, 0);
+}
+
+inline void FrozenBoundary::add_vertex (double x, double y, int label) {
+    my_x.push_back (x);
+    my_y.push_back (y);
+    my_label.push_back (label);
+}
+
+inline void FrozenBoundary::end_contour () {
+    my_offset.push_back ((int)my_x.size ());
+}
+
+inline int PixmapRowReader::size1 () const {
+    return my_p.size1 ();
+}
+
+inline int PixmapRowReader::size2 () const {
+    return my_p.size2 ();
+}
+
+inline void PixmapRowReader::read_row (int j, Pixmap::val_t *row) {
+    for (int i = 0; i != my_p.size1 (); ++i)
+        row[i] = my_p (i, j);
+}
+
 inline void fix_contours (Boundary *b, bool silent) {
     b->fix_contours (silent);
 }